@@ -1,9 +1,13 @@
 INCLUDEPATH += "$$PWD/"
 
+QT += concurrent
+
 SOURCES += \
     $$PWD/agaveInterfaces/agavehandler.cpp \
     $$PWD/agaveInterfaces/agavetaskguide.cpp \
     $$PWD/agaveInterfaces/agavetaskreply.cpp \
+    $$PWD/agaveInterfaces/agavelistingparser.cpp \
+    $$PWD/agaveInterfaces/agaverequeststats.cpp \
     $$PWD/remotedatainterface.cpp \
     $$PWD/filemetadata.cpp \
     $$PWD/remotejobdata.cpp \
@@ -23,6 +27,8 @@ HEADERS += \
     $$PWD/agaveInterfaces/agavehandler.h \
     $$PWD/agaveInterfaces/agavetaskguide.h \
     $$PWD/agaveInterfaces/agavetaskreply.h \
+    $$PWD/agaveInterfaces/agavelistingparser.h \
+    $$PWD/agaveInterfaces/agaverequeststats.h \
     $$PWD/remotedatainterface.h \
     $$PWD/filemetadata.h \
     $$PWD/remotejobdata.h \
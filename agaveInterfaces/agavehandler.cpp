@@ -40,6 +40,13 @@
 
 #include "filemetadata.h"
 
+#include <QRandomGenerator>
+#include <QCryptographicHash>
+#include <QPasswordDigestor>
+
+#include <algorithm>
+#include <climits>
+
 //TODO: need to do more double checking of valid file paths
 
 AgaveHandler::AgaveHandler(QNetworkAccessManager *netAccessManager, QObject *parent) :
@@ -47,6 +54,20 @@ AgaveHandler::AgaveHandler(QNetworkAccessManager *netAccessManager, QObject *par
 {
     networkHandle = netAccessManager;
     SSLoptions.setProtocol(QSsl::SecureProtocols);
+    responseCache.setMaxCost(16 * 1024 * 1024);
+    requestStats = QSharedPointer<AgaveRequestStats>::create();
+
+    //Built-in task guides have a fixed place, so registered apps always go after them
+    taskGuideTable.fill(nullptr, static_cast<int>(AgaveTaskType::REGISTERED_APP));
+
+    tokenRefreshTimer = new QTimer(this);
+    tokenRefreshTimer->setSingleShot(true);
+    QObject::connect(tokenRefreshTimer, SIGNAL(timeout()), this, SLOT(refreshAccessToken()));
+
+    retryTimer = new QTimer(this);
+    retryTimer->setSingleShot(true);
+    QObject::connect(retryTimer, SIGNAL(timeout()), this, SLOT(sendDueRetries()));
+
     changeAuthState(RemoteDataInterfaceState::INIT);
 
     if (networkHandle == nullptr)
@@ -55,7 +76,206 @@ AgaveHandler::AgaveHandler(QNetworkAccessManager *netAccessManager, QObject *par
     }
 }
 
+AgaveTaskReply * AgaveHandler::submitFromOtherThread(std::function<RemoteDataReply *()> makeRequest)
+{
+    //The calling thread gets a reply at once, without waiting for this thread's event loop. That reply stays
+    //on the calling thread, and the results of the request, made later on this thread, reach it by queued
+    //connections, through a relay beside it. So nothing is given out until the calling thread next handles
+    //its events, and by then the caller has connected, even if that thread has no event loop of its own.
+    AgaveTaskReply * waitingReply = new AgaveTaskReply(this);
+    AgaveTaskReply * relayReply = new AgaveTaskReply(this, waitingReply);
+    waitingReply->forwardSignalsFrom(relayReply, Qt::DirectConnection);
+
+    QSharedPointer<AgaveHandleLink> newLink = QSharedPointer<AgaveHandleLink>::create();
+    newLink->handle = waitingReply;
+    newLink->relay = relayReply;
+    waitingReply->handleLink = newLink;
+    waitingReply->handleRelay = relayReply;
+
+    AgaveSubmission * newSubmission = new AgaveSubmission();
+    newSubmission->makeRequest = makeRequest;
+    newSubmission->handleLink = newLink;
+    pushSubmission(newSubmission);
+    return waitingReply;
+}
+
+AgaveHandleLink::~AgaveHandleLink()
+{
+    if (madeGuide != nullptr) delete madeGuide;
+}
+
+void AgaveHandler::pushSubmission(AgaveSubmission * newSubmission)
+{
+    AgaveSubmission * oldHead;
+    do
+    {
+        oldHead = submittedRequests.loadAcquire();
+        newSubmission->next = oldHead;
+    } while (!submittedRequests.testAndSetRelease(oldHead, newSubmission));
+
+    //Only a submission into an empty list needs to wake this thread, the rest are taken with it
+    if (oldHead == nullptr)
+    {
+        QMetaObject::invokeMethod(this, "takeSubmittedRequests", Qt::QueuedConnection);
+    }
+}
+
+bool AgaveHandler::moveToOwnThread()
+{
+    if (ioThread != nullptr)
+    {
+        return true;
+    }
+    if (QThread::currentThread() != this->thread())
+    {
+        qCDebug(remoteInterface, "ERROR: AgaveHandler can only be moved to its own thread from the thread it was made in");
+        return false;
+    }
+    if (this->parent() != nullptr)
+    {
+        qCDebug(remoteInterface, "ERROR: AgaveHandler with a parent object cannot be moved to its own thread");
+        return false;
+    }
+    if ((currentState != RemoteDataInterfaceState::INIT) && (currentState != RemoteDataInterfaceState::READY_TO_AUTH))
+    {
+        qCDebug(remoteInterface, "ERROR: AgaveHandler must be moved to its own thread before login");
+        return false;
+    }
+
+    //The given network manager belongs to the caller's thread, so the handler makes its own, with the same proxy
+    QNetworkAccessManager * ownNetworkHandle = new QNetworkAccessManager(this);
+    ownNetworkHandle->setProxy(networkHandle->proxy());
+    networkHandle = ownNetworkHandle;
+
+    ioThread = new QThread();
+    ioThread->setObjectName("AgaveHandler I/O");
+    QObject::connect(this, SIGNAL(destroyed()), ioThread, SLOT(quit()), Qt::DirectConnection);
+    QObject::connect(ioThread, SIGNAL(finished()), ioThread, SLOT(deleteLater()));
+
+    this->moveToThread(ioThread);
+    ioThread->start();
+
+    //A connection already made belongs to the old network manager, so the new one makes its own
+    if (currentState == RemoteDataInterfaceState::READY_TO_AUTH)
+    {
+        QMetaObject::invokeMethod(this, "prewarmConnection", Qt::QueuedConnection);
+    }
+    return true;
+}
+
+QMap<QString, AgaveTaskStats> AgaveHandler::getRequestStats()
+{
+    return requestStats->getTaskStats();
+}
+
+void AgaveHandler::resetRequestStats()
+{
+    requestStats->reset();
+}
+
+void AgaveHandler::takeSubmittedRequests()
+{
+    AgaveSubmission * takenList = submittedRequests.fetchAndStoreAcquire(nullptr);
+
+    //The list is newest first, so it is reversed, to make the requests in the order they were submitted
+    AgaveSubmission * inOrder = nullptr;
+    while (takenList != nullptr)
+    {
+        AgaveSubmission * nextTaken = takenList->next;
+        takenList->next = inOrder;
+        inOrder = takenList;
+        takenList = nextTaken;
+    }
+
+    while (inOrder != nullptr)
+    {
+        AgaveSubmission * thisSubmission = inOrder;
+        inOrder = inOrder->next;
+        std::function<RemoteDataReply *()> makeRequest = thisSubmission->makeRequest;
+        QSharedPointer<AgaveHandleLink> theLink = thisSubmission->handleLink;
+        delete thisSubmission;
+
+        QMutexLocker linkLocker(&theLink->linkLock);
+
+        //A handle deleted before its request was made needs nothing
+        if (theLink->handle == nullptr) continue;
+
+        //Making the request may open files and start network I/O, so the caller's thread is not kept
+        //waiting on the lock meanwhile. The handle may be stopped or deleted before the lock is taken again.
+        linkLocker.unlock();
+        AgaveTaskReply * madeReply = qobject_cast<AgaveTaskReply *>(makeRequest());
+
+        //The handle keeps its own copy of the guide, since it may outlive this handler
+        AgaveTaskGuide * guideCopy = nullptr;
+        if ((madeReply != nullptr) && (madeReply->getTaskGuide() != nullptr))
+        {
+            guideCopy = new AgaveTaskGuide(*madeReply->getTaskGuide());
+        }
+        linkLocker.relock();
+
+        if (madeReply == nullptr)
+        {
+            qCDebug(remoteInterface, "ERROR: Request submitted from other thread gave no reply.");
+            if (theLink->handle != nullptr)
+            {
+                QMetaObject::invokeMethod(theLink->handle, "deleteLater", Qt::QueuedConnection);
+            }
+            continue;
+        }
+
+        theLink->madeReply = madeReply;
+        theLink->madeGuide = guideCopy;
+        theLink->requestMade = true;
+        QObject::connect(madeReply, &QObject::destroyed, [theLink]()
+        {
+            QMutexLocker doneLocker(&theLink->linkLock);
+            theLink->requestDone = true;
+        });
+
+        //A handle stopped before its request was made gives its stopped state, now that it knows the task
+        //A handle deleted meanwhile needs nothing, and its request is stopped
+        if (theLink->released)
+        {
+            if (theLink->handle != nullptr)
+            {
+                QMetaObject::invokeMethod(theLink->handle, "finishStoppedRequest", Qt::QueuedConnection);
+            }
+            linkLocker.unlock();
+            madeReply->stopIfUnwatched();
+            continue;
+        }
+
+        theLink->relay->forwardSignalsFrom(madeReply, Qt::QueuedConnection);
+        QObject::connect(madeReply, SIGNAL(destroyed()), theLink->handle, SLOT(deleteLater()), Qt::QueuedConnection);
+    }
+}
+
 void AgaveHandler::finishedOneTask()
+{
+    //The reply is only used to look up which class it held a place in, it is never dereferenced
+    QNetworkReply * finishedReply = static_cast<QNetworkReply *>(sender());
+    if (activeRequestClass.contains(finishedReply))
+    {
+        activeRequestCount[activeRequestClass.take(finishedReply)]--;
+    }
+
+    for (auto itr = sharedReadRequests.begin(); itr != sharedReadRequests.end();)
+    {
+        if ((*itr).isNull() || !(*itr)->canTakeFollowers())
+        {
+            itr = sharedReadRequests.erase(itr);
+        }
+        else
+        {
+            itr++;
+        }
+    }
+
+    decrementPendingRequests();
+    issueQueuedRequests();
+}
+
+void AgaveHandler::decrementPendingRequests()
 {
     pendingRequestCount--;
     if (pendingRequestCount < 0)
@@ -80,9 +300,14 @@ AgaveHandler::~AgaveHandler()
     {
         qCDebug(remoteInterface, "ERROR: Agave Handler destroyed without proper shutdown");
     }
-    foreach (AgaveTaskGuide * aTaskGuide , validTaskList)
+    qDeleteAll(taskGuideTable);
+
+    AgaveSubmission * leftoverSubmission = submittedRequests.fetchAndStoreAcquire(nullptr);
+    while (leftoverSubmission != nullptr)
     {
-        delete aTaskGuide;
+        AgaveSubmission * nextSubmission = leftoverSubmission->next;
+        delete leftoverSubmission;
+        leftoverSubmission = nextSubmission;
     }
 }
 
@@ -107,35 +332,90 @@ RemoteDataReply * AgaveHandler::performAuth(QString uname, QString passwd)
 {   
     if (QThread::currentThread() != this->thread())
     {
-        RemoteDataReply * retVal = nullptr;
-        QMetaObject::invokeMethod(this, "performAuth", Qt::BlockingQueuedConnection,
-                                  Q_RETURN_ARG(RemoteDataReply *, retVal),
-                                  Q_ARG(QString, uname),
-                                  Q_ARG(QString, passwd));
-        return retVal;
+        return submitFromOtherThread([=]() { return performAuth(uname, passwd); });
     }
 
     if (currentState != RemoteDataInterfaceState::READY_TO_AUTH)
     {
         qCDebug(remoteInterface, "Login attempted in wrong state.");
-        return createDirectReply("fullAuth", RequestState::INVALID_STATE);
+        return createDirectReply(AgaveTaskType::FULL_AUTH, RequestState::INVALID_STATE);
     }
     changeAuthState(RemoteDataInterfaceState::AUTH_TRY);
+    loginTimer.start();
+    firstListingRequestTimer.invalidate();
+    firstListingArrived = false;
 
     authUname = uname;
     authPass = passwd;
+    passwordSalt.clear();
+    passwordHash.clear();
 
     authEncoded = "Basic ";
-    QByteArray rawAuth(uname.toLatin1());
+    //As with every other credential, the user name and password are sent as UTF-8
+    QByteArray rawAuth(uname.toUtf8());
     rawAuth.append(":");
-    rawAuth.append(passwd);
+    rawAuth.append(passwd.toUtf8());
     authEncoded.append(rawAuth.toBase64());
 
-    AgaveTaskReply * parentReply = new AgaveTaskReply(retriveTaskGuide("fullAuth"),nullptr,this,qobject_cast<QObject *>(this));
+    //A stored client skips client registration, and a stored token, still good, skips the rest
+    QJsonObject storedLogin = readStoredCredentials();
+    clientKey = storedLogin.value("clientKey").toString();
+    clientSecret = storedLogin.value("clientSecret").toString();
+    bool haveStoredClient = (!clientKey.isEmpty() && !clientSecret.isEmpty());
+
+    if (haveStoredClient)
+    {
+        encodeClientCredentials();
+
+        QByteArray storedToken = storedLogin.value("token").toString().toLatin1();
+        QByteArray storedRefreshToken = storedLogin.value("refreshToken").toString().toLatin1();
+        QDateTime storedExpiry = QDateTime::fromString(storedLogin.value("tokenExpiry").toString(), Qt::ISODate);
+        qint64 tokenTimeLeft = QDateTime::currentDateTimeUtc().secsTo(storedExpiry);
+
+        //A stored token is only used with the password it was got with. Any other password goes through the full login,
+        //so that the server checks it.
+        //Hashes made another way, or with fewer rounds, are not trusted.
+        QByteArray storedSalt = QByteArray::fromBase64(storedLogin.value("passwordSalt").toString().toLatin1());
+        QByteArray storedHash = QByteArray::fromBase64(storedLogin.value("passwordHash").toString().toLatin1());
+        bool passwordMatches = (!storedSalt.isEmpty() && !storedHash.isEmpty() &&
+                                (storedLogin.value("passwordKdf").toString() == "pbkdf2-sha256") &&
+                                (storedLogin.value("passwordRounds").toInt() == passwordHashRounds) &&
+                                (hashStoredPassword(passwd, storedSalt) == storedHash));
+        if (passwordMatches)
+        {
+            passwordSalt = storedSalt;
+            passwordHash = storedHash;
+        }
+
+        if (passwordMatches && !storedToken.isEmpty() && !storedRefreshToken.isEmpty() && storedExpiry.isValid() && (tokenTimeLeft > 60))
+        {
+            token = storedToken;
+            refreshToken = storedRefreshToken;
+            tokenHeader = (QString("Bearer ").append(token)).toLatin1();
+
+            changeAuthState(RemoteDataInterfaceState::CONNECTED);
+            scheduleTokenRefresh(tokenTimeLeft);
+            qCDebug(remoteInterface, "Login success, using stored token.");
+            return createDirectReply(AgaveTaskType::FULL_AUTH, RequestState::GOOD);
+        }
+    }
+
+    AgaveTaskReply * parentReply = new AgaveTaskReply(retriveTaskGuide(AgaveTaskType::FULL_AUTH),nullptr,this,qobject_cast<QObject *>(this));
     QMap<QString, QByteArray> taskVars;
-    parentReply->getTaskParamList()->insert("uname", uname.toLatin1());
-    parentReply->getTaskParamList()->insert("passwd", passwd.toLatin1());
-    performAgaveQuery("authStep1", taskVars, parentReply);
+    parentReply->getTaskParamList()->insert("uname", uname.toUtf8());
+    parentReply->getTaskParamList()->insert("passwd", passwd.toUtf8());
+
+    if (haveStoredClient)
+    {
+        parentReply->getTaskParamList()->insert("storedClient", "true");
+        taskVars.insert("authUname", authUname.toUtf8());
+        taskVars.insert("authPass", authPass.toUtf8());
+        performAgaveQuery(AgaveTaskType::AUTH_STEP3, taskVars, parentReply);
+    }
+    else
+    {
+        performAgaveQuery(AgaveTaskType::AUTH_STEP1, taskVars, parentReply);
+    }
 
     return qobject_cast<RemoteDataReply *>(parentReply);
 }
@@ -144,24 +424,48 @@ RemoteDataReply * AgaveHandler::remoteLS(QString dirPath)
 {
     if (QThread::currentThread() != this->thread())
     {
-        RemoteDataReply * retVal = nullptr;
-        QMetaObject::invokeMethod(this, "remoteLS", Qt::BlockingQueuedConnection,
-                                  Q_RETURN_ARG(RemoteDataReply *, retVal),
-                                  Q_ARG(QString, dirPath));
-        return retVal;
+        return submitFromOtherThread([=]() { return remoteLS(dirPath); });
+    }
+
+    if ((dirPath.isEmpty()) || (dirPath == ""))
+    {
+        dirPath = "/";
+    }
+    if (!remotePathStringIsValid(dirPath)) return createDirectReply(AgaveTaskType::DIR_LISTING, RequestState::INVALID_PARAM);
+    if (currentState != RemoteDataInterfaceState::CONNECTED) return createDirectReply(AgaveTaskType::DIR_LISTING, RequestState::INVALID_STATE);
+    noteListingRequested();
+
+    if (listingPageSize > 0)
+    {
+        return qobject_cast<RemoteDataReply *>(performPagedListing(dirPath));
+    }
+
+    QMap<QString, QByteArray> taskVars;
+    taskVars.insert("dirPath", dirPath.toUtf8());
+
+    AgaveTaskReply * theReply = performAgaveQuery(AgaveTaskType::DIR_LISTING, taskVars);
+    return qobject_cast<RemoteDataReply *>(theReply);
+}
+
+RemoteDataReply * AgaveHandler::remoteLSBatches(QString dirPath)
+{
+    if (QThread::currentThread() != this->thread())
+    {
+        return submitFromOtherThread([=]() { return remoteLSBatches(dirPath); });
     }
 
     if ((dirPath.isEmpty()) || (dirPath == ""))
     {
         dirPath = "/";
     }
-    if (!remotePathStringIsValid(dirPath)) return createDirectReply("dirListing", RequestState::INVALID_PARAM);
-    if (currentState != RemoteDataInterfaceState::CONNECTED) return createDirectReply("dirListing", RequestState::INVALID_STATE);
+    if (!remotePathStringIsValid(dirPath)) return createDirectReply(AgaveTaskType::DIR_LISTING_BATCHES, RequestState::INVALID_PARAM);
+    if (currentState != RemoteDataInterfaceState::CONNECTED) return createDirectReply(AgaveTaskType::DIR_LISTING_BATCHES, RequestState::INVALID_STATE);
+    noteListingRequested();
 
     QMap<QString, QByteArray> taskVars;
-    taskVars.insert("dirPath", dirPath.toLatin1());
+    taskVars.insert("dirPath", dirPath.toUtf8());
 
-    AgaveTaskReply * theReply = performAgaveQuery("dirListing", taskVars);
+    AgaveTaskReply * theReply = performAgaveQuery(AgaveTaskType::DIR_LISTING_BATCHES, taskVars);
     return qobject_cast<RemoteDataReply *>(theReply);
 }
 
@@ -169,20 +473,16 @@ RemoteDataReply * AgaveHandler::deleteFile(QString toDelete)
 {
     if (QThread::currentThread() != this->thread())
     {
-        RemoteDataReply * retVal = nullptr;
-        QMetaObject::invokeMethod(this, "deleteFile", Qt::BlockingQueuedConnection,
-                                  Q_RETURN_ARG(RemoteDataReply *, retVal),
-                                  Q_ARG(QString, toDelete));
-        return retVal;
+        return submitFromOtherThread([=]() { return deleteFile(toDelete); });
     }
 
-    if (!remotePathStringIsValid(toDelete)) return createDirectReply("fileDelete", RequestState::INVALID_PARAM);
-    if (currentState != RemoteDataInterfaceState::CONNECTED) return createDirectReply("fileDelete", RequestState::INVALID_STATE);
+    if (!remotePathStringIsValid(toDelete)) return createDirectReply(AgaveTaskType::FILE_DELETE, RequestState::INVALID_PARAM);
+    if (currentState != RemoteDataInterfaceState::CONNECTED) return createDirectReply(AgaveTaskType::FILE_DELETE, RequestState::INVALID_STATE);
 
     QMap<QString, QByteArray> taskVars;
-    taskVars.insert("toDelete", toDelete.toLatin1());
+    taskVars.insert("toDelete", toDelete.toUtf8());
 
-    AgaveTaskReply * theReply = performAgaveQuery("fileDelete", taskVars);
+    AgaveTaskReply * theReply = performAgaveQuery(AgaveTaskType::FILE_DELETE, taskVars);
     return qobject_cast<RemoteDataReply *>(theReply);
 }
 
@@ -190,23 +490,18 @@ RemoteDataReply * AgaveHandler::moveFile(QString from, QString to)
 {
     if (QThread::currentThread() != this->thread())
     {
-        RemoteDataReply * retVal = nullptr;
-        QMetaObject::invokeMethod(this, "moveFile", Qt::BlockingQueuedConnection,
-                                  Q_RETURN_ARG(RemoteDataReply *, retVal),
-                                  Q_ARG(QString, from),
-                                  Q_ARG(QString, to));
-        return retVal;
+        return submitFromOtherThread([=]() { return moveFile(from, to); });
     }
 
-    if (!remotePathStringIsValid(from)) return createDirectReply("fileMove", RequestState::INVALID_PARAM);
-    if (!remotePathStringIsValid(to)) return createDirectReply("fileMove", RequestState::INVALID_PARAM);
-    if (currentState != RemoteDataInterfaceState::CONNECTED) return createDirectReply("fileMove", RequestState::INVALID_STATE);
+    if (!remotePathStringIsValid(from)) return createDirectReply(AgaveTaskType::FILE_MOVE, RequestState::INVALID_PARAM);
+    if (!remotePathStringIsValid(to)) return createDirectReply(AgaveTaskType::FILE_MOVE, RequestState::INVALID_PARAM);
+    if (currentState != RemoteDataInterfaceState::CONNECTED) return createDirectReply(AgaveTaskType::FILE_MOVE, RequestState::INVALID_STATE);
 
     QMap<QString, QByteArray> taskVars;
-    taskVars.insert("from", from.toLatin1());
-    taskVars.insert("to", to.toLatin1());
+    taskVars.insert("from", from.toUtf8());
+    taskVars.insert("to", to.toUtf8());
 
-    AgaveTaskReply * theReply = performAgaveQuery("fileMove", taskVars);
+    AgaveTaskReply * theReply = performAgaveQuery(AgaveTaskType::FILE_MOVE, taskVars);
     return qobject_cast<RemoteDataReply *>(theReply);
 }
 
@@ -214,23 +509,18 @@ RemoteDataReply * AgaveHandler::copyFile(QString from, QString to)
 {
     if (QThread::currentThread() != this->thread())
     {
-        RemoteDataReply * retVal = nullptr;
-        QMetaObject::invokeMethod(this, "copyFile", Qt::BlockingQueuedConnection,
-                                  Q_RETURN_ARG(RemoteDataReply *, retVal),
-                                  Q_ARG(QString, from),
-                                  Q_ARG(QString, to));
-        return retVal;
+        return submitFromOtherThread([=]() { return copyFile(from, to); });
     }
 
-    if (!remotePathStringIsValid(from)) return createDirectReply("fileCopy", RequestState::INVALID_PARAM);
-    if (!remotePathStringIsValid(to)) return createDirectReply("fileCopy", RequestState::INVALID_PARAM);
-    if (currentState != RemoteDataInterfaceState::CONNECTED) return createDirectReply("fileCopy", RequestState::INVALID_STATE);
+    if (!remotePathStringIsValid(from)) return createDirectReply(AgaveTaskType::FILE_COPY, RequestState::INVALID_PARAM);
+    if (!remotePathStringIsValid(to)) return createDirectReply(AgaveTaskType::FILE_COPY, RequestState::INVALID_PARAM);
+    if (currentState != RemoteDataInterfaceState::CONNECTED) return createDirectReply(AgaveTaskType::FILE_COPY, RequestState::INVALID_STATE);
 
     QMap<QString, QByteArray> taskVars;
-    taskVars.insert("from", from.toLatin1());
-    taskVars.insert("to", to.toLatin1());
+    taskVars.insert("from", from.toUtf8());
+    taskVars.insert("to", to.toUtf8());
 
-    AgaveTaskReply * theReply = performAgaveQuery("fileCopy", taskVars);
+    AgaveTaskReply * theReply = performAgaveQuery(AgaveTaskType::FILE_COPY, taskVars);
     return qobject_cast<RemoteDataReply *>(theReply);
 }
 
@@ -238,47 +528,78 @@ RemoteDataReply * AgaveHandler::renameFile(QString fullName, QString newName)
 {
     if (QThread::currentThread() != this->thread())
     {
-        RemoteDataReply * retVal = nullptr;
-        QMetaObject::invokeMethod(this, "renameFile", Qt::BlockingQueuedConnection,
-                                  Q_RETURN_ARG(RemoteDataReply *, retVal),
-                                  Q_ARG(QString, fullName),
-                                  Q_ARG(QString, newName));
-        return retVal;
+        return submitFromOtherThread([=]() { return renameFile(fullName, newName); });
     }
 
-    if (!remotePathStringIsValid(fullName)) return createDirectReply("renameFile", RequestState::INVALID_PARAM);
-    if (currentState != RemoteDataInterfaceState::CONNECTED) return createDirectReply("renameFile", RequestState::INVALID_STATE);
+    if (!remotePathStringIsValid(fullName)) return createDirectReply(AgaveTaskType::RENAME_FILE, RequestState::INVALID_PARAM);
+    if (currentState != RemoteDataInterfaceState::CONNECTED) return createDirectReply(AgaveTaskType::RENAME_FILE, RequestState::INVALID_STATE);
     //TODO: check newName is valid
 
     QMap<QString, QByteArray> taskVars;
-    taskVars.insert("fullName", fullName.toLatin1());
-    taskVars.insert("newName", newName.toLatin1());
+    taskVars.insert("fullName", fullName.toUtf8());
+    taskVars.insert("newName", newName.toUtf8());
 
-    AgaveTaskReply * theReply = performAgaveQuery("renameFile", taskVars);
+    AgaveTaskReply * theReply = performAgaveQuery(AgaveTaskType::RENAME_FILE, taskVars);
     return qobject_cast<RemoteDataReply *>(theReply);
 }
 
+RemoteDataReply * AgaveHandler::batchFileOperations(QList<RemoteFileOperation> operationList)
+{
+    if (QThread::currentThread() != this->thread())
+    {
+        return submitFromOtherThread([=]() { return batchFileOperations(operationList); });
+    }
+
+    if (operationList.isEmpty()) return createDirectReply(AgaveTaskType::FILE_BATCH, RequestState::INVALID_PARAM);
+    if (currentState != RemoteDataInterfaceState::CONNECTED) return createDirectReply(AgaveTaskType::FILE_BATCH, RequestState::INVALID_STATE);
+
+    AgaveTaskReply * batchReply = new AgaveTaskReply(retriveTaskGuide(AgaveTaskType::FILE_BATCH), nullptr, this, qobject_cast<QObject *>(this));
+
+    //Items which cannot be sent fail at once, and the rest wait their turn
+    int validItems = 0;
+    for (const RemoteFileOperation &anOperation : operationList)
+    {
+        RemoteFileOpResult newItem;
+        newItem.theOperation = anOperation;
+        if (getFileOpTask(anOperation, nullptr) == AgaveTaskType::FILE_BATCH)
+        {
+            newItem.resultState = RequestState::INVALID_PARAM;
+            batchReply->batchItemsDone++;
+            batchReply->batchItemsFailed++;
+        }
+        else
+        {
+            validItems++;
+        }
+        batchReply->batchResults.append(newItem);
+    }
+
+    if (validItems == 0)
+    {
+        delete batchReply;
+        return createDirectReply(AgaveTaskType::FILE_BATCH, RequestState::INVALID_PARAM);
+    }
+
+    sendBatchItems(batchReply);
+    return qobject_cast<RemoteDataReply *>(batchReply);
+}
+
 RemoteDataReply * AgaveHandler::mkRemoteDir(QString location, QString newName)
 {
     if (QThread::currentThread() != this->thread())
     {
-        RemoteDataReply * retVal = nullptr;
-        QMetaObject::invokeMethod(this, "mkRemoteDir", Qt::BlockingQueuedConnection,
-                                  Q_RETURN_ARG(RemoteDataReply *, retVal),
-                                  Q_ARG(QString, location),
-                                  Q_ARG(QString, newName));
-        return retVal;
+        return submitFromOtherThread([=]() { return mkRemoteDir(location, newName); });
     }
 
-    if (!remotePathStringIsValid(location)) return createDirectReply("newFolder", RequestState::INVALID_PARAM);
-    if (currentState != RemoteDataInterfaceState::CONNECTED) return createDirectReply("newFolder", RequestState::INVALID_STATE);
+    if (!remotePathStringIsValid(location)) return createDirectReply(AgaveTaskType::NEW_FOLDER, RequestState::INVALID_PARAM);
+    if (currentState != RemoteDataInterfaceState::CONNECTED) return createDirectReply(AgaveTaskType::NEW_FOLDER, RequestState::INVALID_STATE);
     //TODO: check newName is valid
 
     QMap<QString, QByteArray> taskVars;
-    taskVars.insert("location", location.toLatin1());
-    taskVars.insert("newName", newName.toLatin1());
+    taskVars.insert("location", location.toUtf8());
+    taskVars.insert("newName", newName.toUtf8());
 
-    AgaveTaskReply * theReply = performAgaveQuery("newFolder", taskVars);
+    AgaveTaskReply * theReply = performAgaveQuery(AgaveTaskType::NEW_FOLDER, taskVars);
     return qobject_cast<RemoteDataReply *>(theReply);
 }
 
@@ -286,73 +607,90 @@ RemoteDataReply * AgaveHandler::uploadFile(QString location, QString localFileNa
 {
     if (QThread::currentThread() != this->thread())
     {
-        RemoteDataReply * retVal = nullptr;
-        QMetaObject::invokeMethod(this, "uploadFile", Qt::BlockingQueuedConnection,
-                                  Q_RETURN_ARG(RemoteDataReply *, retVal),
-                                  Q_ARG(QString, location),
-                                  Q_ARG(QString, localFileName));
-        return retVal;
+        return submitFromOtherThread([=]() { return uploadFile(location, localFileName); });
     }
 
-    if (!remotePathStringIsValid(location)) return createDirectReply("fileUpload", RequestState::INVALID_PARAM);
-    if (currentState != RemoteDataInterfaceState::CONNECTED) return createDirectReply("fileUpload", RequestState::INVALID_STATE);
+    if (!remotePathStringIsValid(location)) return createDirectReply(AgaveTaskType::FILE_UPLOAD, RequestState::INVALID_PARAM);
+    if (currentState != RemoteDataInterfaceState::CONNECTED) return createDirectReply(AgaveTaskType::FILE_UPLOAD, RequestState::INVALID_STATE);
     //TODO: check that local file exists
 
+    qint64 fileSize = QFileInfo(localFileName).size();
+    if ((chunkedUploadThreshold >= 0) && (fileSize >= chunkedUploadThreshold) && (fileSize > 0) && !chunkedUploadRefused)
+    {
+        return qobject_cast<RemoteDataReply *>(performChunkedUpload(location, localFileName, fileSize));
+    }
+
     QMap<QString, QByteArray> taskVars;
-    taskVars.insert("location", location.toLatin1());
-    taskVars.insert("localFileName", localFileName.toLatin1());
+    taskVars.insert("location", location.toUtf8());
+    taskVars.insert("localFileName", localFileName.toUtf8());
 
-    AgaveTaskReply * theReply = performAgaveQuery("fileUpload", taskVars);
+    AgaveTaskReply * theReply = performAgaveQuery(AgaveTaskType::FILE_UPLOAD, taskVars);
     return qobject_cast<RemoteDataReply *>(theReply);
 }
 
-RemoteDataReply * AgaveHandler::uploadBuffer(QString location, QByteArray fileData, QString newFileName)
+RemoteDataReply * AgaveHandler::uploadBuffer(QString location, const QByteArray &fileData, QString newFileName)
 {
     if (QThread::currentThread() != this->thread())
     {
-        RemoteDataReply * retVal = nullptr;
-        QMetaObject::invokeMethod(this, "uploadBuffer", Qt::BlockingQueuedConnection,
-                                  Q_RETURN_ARG(RemoteDataReply *, retVal),
-                                  Q_ARG(QString, location),
-                                  Q_ARG(QByteArray, fileData),
-                                  Q_ARG(QString, newFileName));
-        return retVal;
+        return submitFromOtherThread([=]() { return uploadBuffer(location, fileData, newFileName); });
     }
 
-    if (!remotePathStringIsValid(location)) return createDirectReply("filePipeUpload", RequestState::INVALID_PARAM);
-    if (currentState != RemoteDataInterfaceState::CONNECTED) return createDirectReply("filePipeUpload", RequestState::INVALID_STATE);
+    if (!remotePathStringIsValid(location)) return createDirectReply(AgaveTaskType::FILE_PIPE_UPLOAD, RequestState::INVALID_PARAM);
+    if (currentState != RemoteDataInterfaceState::CONNECTED) return createDirectReply(AgaveTaskType::FILE_PIPE_UPLOAD, RequestState::INVALID_STATE);
     //TODO: check newFileName is valid
 
     QMap<QString, QByteArray> taskVars;
-    taskVars.insert("location", location.toLatin1());
-    taskVars.insert("newFileName", newFileName.toLatin1());
+    taskVars.insert("location", location.toUtf8());
+    taskVars.insert("newFileName", newFileName.toUtf8());
     taskVars.insert("fileData", fileData);
 
-    AgaveTaskReply * theReply = performAgaveQuery("filePipeUpload",taskVars);
+    AgaveTaskReply * theReply = performAgaveQuery(AgaveTaskType::FILE_PIPE_UPLOAD,taskVars);
     return qobject_cast<RemoteDataReply *>(theReply);
 }
 
-RemoteDataReply * AgaveHandler::downloadFile(QString localDest, QString remoteName)
+RemoteDataReply * AgaveHandler::downloadFile(QString localDest, QString remoteName, qint64 remoteSize)
 {
     if (QThread::currentThread() != this->thread())
     {
-        RemoteDataReply * retVal = nullptr;
-        QMetaObject::invokeMethod(this, "downloadFile", Qt::BlockingQueuedConnection,
-                                  Q_RETURN_ARG(RemoteDataReply *, retVal),
-                                  Q_ARG(QString, localDest),
-                                  Q_ARG(QString, remoteName));
-        return retVal;
+        return submitFromOtherThread([=]() { return downloadFile(localDest, remoteName, remoteSize); });
     }
 
-    if (!remotePathStringIsValid(remoteName)) return createDirectReply("fileDownload", RequestState::INVALID_PARAM);
-    if (currentState != RemoteDataInterfaceState::CONNECTED) return createDirectReply("fileDownload", RequestState::INVALID_STATE);
+    if (!remotePathStringIsValid(remoteName)) return createDirectReply(AgaveTaskType::FILE_DOWNLOAD, RequestState::INVALID_PARAM);
+    if (currentState != RemoteDataInterfaceState::CONNECTED) return createDirectReply(AgaveTaskType::FILE_DOWNLOAD, RequestState::INVALID_STATE);
     //TODO: check localDest exists
 
     QMap<QString, QByteArray> taskVars;
-    taskVars.insert("remoteName", remoteName.toLatin1());
-    taskVars.insert("localDest", localDest.toLatin1());
+    taskVars.insert("remoteName", remoteName.toUtf8());
+    taskVars.insert("localDest", localDest.toUtf8());
+
+    //A partial file left by an earlier failed attempt lets the download continue where it stopped
+    QJsonObject downloadRecord = AgaveTaskReply::readDownloadRecord(localDest);
+    if (downloadRecord.value("remotePath").toString() == remoteName)
+    {
+        qint64 bytesDone = static_cast<qint64>(downloadRecord.value("bytesDone").toDouble());
+        qint64 expectedSize = static_cast<qint64>(downloadRecord.value("expectedSize").toDouble());
+        bytesDone = qMin(bytesDone, QFileInfo(localDest + ".part").size());
+        bool sizeMatches = ((expectedSize > 0) && ((remoteSize < 0) || (remoteSize == expectedSize)));
+
+        //A segmented download's file is sized up front, and each segment goes on from what it recorded
+        if (sizeMatches && downloadRecord.value("segments").isArray() && (QFileInfo(localDest + ".part").size() == expectedSize))
+        {
+            return qobject_cast<RemoteDataReply *>(performSegmentedDownload(localDest, remoteName, expectedSize, downloadRecord.value("segments").toArray()));
+        }
+
+        if ((bytesDone > 0) && sizeMatches)
+        {
+            taskVars.insert("resumeFrom", QByteArray::number(bytesDone));
+            taskVars.insert("expectedSize", QByteArray::number(expectedSize));
+        }
+    }
 
-    AgaveTaskReply * theReply = performAgaveQuery("fileDownload", taskVars);
+    if (!taskVars.contains("resumeFrom") && (maxDownloadSegments > 1) && (remoteSize >= segmentedDownloadThreshold))
+    {
+        return qobject_cast<RemoteDataReply *>(performSegmentedDownload(localDest, remoteName, remoteSize));
+    }
+
+    AgaveTaskReply * theReply = performAgaveQuery(AgaveTaskType::FILE_DOWNLOAD, taskVars);
     return qobject_cast<RemoteDataReply *>(theReply);
 }
 
@@ -360,20 +698,28 @@ RemoteDataReply * AgaveHandler::downloadBuffer(QString remoteName)
 {
     if (QThread::currentThread() != this->thread())
     {
-        RemoteDataReply * retVal = nullptr;
-        QMetaObject::invokeMethod(this, "downloadBuffer", Qt::BlockingQueuedConnection,
-                                  Q_RETURN_ARG(RemoteDataReply *, retVal),
-                                  Q_ARG(QString, remoteName));
-        return retVal;
+        return submitFromOtherThread([=]() { return downloadBuffer(remoteName); });
     }
 
-    if (!remotePathStringIsValid(remoteName)) return createDirectReply("filePipeDownload", RequestState::INVALID_PARAM);
-    if (currentState != RemoteDataInterfaceState::CONNECTED) return createDirectReply("filePipeDownload", RequestState::INVALID_STATE);
+    if (!remotePathStringIsValid(remoteName)) return createDirectReply(AgaveTaskType::FILE_PIPE_DOWNLOAD, RequestState::INVALID_PARAM);
+    if (currentState != RemoteDataInterfaceState::CONNECTED) return createDirectReply(AgaveTaskType::FILE_PIPE_DOWNLOAD, RequestState::INVALID_STATE);
 
     QMap<QString, QByteArray> taskVars;
-    taskVars.insert("remoteName", remoteName.toLatin1());
+    taskVars.insert("remoteName", remoteName.toUtf8());
 
-    AgaveTaskReply * theReply = performAgaveQuery("filePipeDownload", taskVars);
+    QPair<qint64, QByteArray> partialData = partialBufferDownloads.take(remoteName);
+    if (!partialData.second.isEmpty())
+    {
+        taskVars.insert("resumeFrom", QByteArray::number(partialData.second.size()));
+        taskVars.insert("expectedSize", QByteArray::number(partialData.first));
+    }
+
+    AgaveTaskReply * theReply = performAgaveQuery(AgaveTaskType::FILE_PIPE_DOWNLOAD, taskVars);
+    if (!partialData.second.isEmpty())
+    {
+        theReply->pipeBuffer = partialData.second;
+        theReply->expectedDownloadSize = partialData.first;
+    }
     return qobject_cast<RemoteDataReply *>(theReply);
 }
 
@@ -381,15 +727,12 @@ AgaveTaskReply * AgaveHandler::getAgaveAppList()
 {
     if (QThread::currentThread() != this->thread())
     {
-        AgaveTaskReply * retVal = nullptr;
-        QMetaObject::invokeMethod(this, "getAgaveAppList", Qt::BlockingQueuedConnection,
-                                  Q_RETURN_ARG(AgaveTaskReply *, retVal));
-        return retVal;
+        return submitFromOtherThread([=]() { return getAgaveAppList(); });
     }
 
-    if (currentState != RemoteDataInterfaceState::CONNECTED) return createDirectReply("getAgaveList", RequestState::INVALID_STATE);
+    if (currentState != RemoteDataInterfaceState::CONNECTED) return createDirectReply(AgaveTaskType::GET_AGAVE_LIST, RequestState::INVALID_STATE);
 
-    return performAgaveQuery("getAgaveList");
+    return performAgaveQuery(AgaveTaskType::GET_AGAVE_LIST);
 }
 
 void AgaveHandler::setAgaveConnectionParams(QString tenant, QString clientId, QString storage)
@@ -414,88 +757,289 @@ void AgaveHandler::setAgaveConnectionParams(QString tenant, QString clientId, QS
     storageNode = storage;
 
     setupTaskGuideList();
+    prewarmConnection();
 
     changeAuthState(RemoteDataInterfaceState::READY_TO_AUTH);
 }
 
-RemoteDataReply * AgaveHandler::runRemoteJob(QString jobName, ParamMap jobParameters, QString remoteWorkingDir, QString indivJobName, QString archivePath)
+void AgaveHandler::prewarmConnection()
+{
+    //The DNS lookup and TCP and TLS handshakes are done now, rather than on the first login request
+    QUrl tenantAddress(tenantURL);
+    if (tenantAddress.scheme() == "https")
+    {
+        networkHandle->connectToHostEncrypted(tenantAddress.host(), static_cast<quint16>(tenantAddress.port(443)), SSLoptions);
+    }
+    else if (!tenantAddress.host().isEmpty())
+    {
+        networkHandle->connectToHost(tenantAddress.host(), static_cast<quint16>(tenantAddress.port(80)));
+    }
+}
+
+void AgaveHandler::setParallelDownloadParams(qint64 minimumFileSize, int maxSegments)
 {
     if (QThread::currentThread() != this->thread())
     {
-        RemoteDataReply * retVal = nullptr;
-        QMetaObject::invokeMethod(this, "runRemoteJob", Qt::BlockingQueuedConnection,
-                                  Q_RETURN_ARG(RemoteDataReply *, retVal),
-                                  Q_ARG(QString, jobName),
-                                  Q_ARG(ParamMap, jobParameters),
-                                  Q_ARG(QString, remoteWorkingDir),
-                                  Q_ARG(QString, indivJobName),
-                                  Q_ARG(QString, archivePath));
-        return retVal;
+        QMetaObject::invokeMethod(this, "setParallelDownloadParams", Qt::BlockingQueuedConnection,
+                                  Q_ARG(qint64, minimumFileSize),
+                                  Q_ARG(int, maxSegments));
+        return;
     }
 
-    if (currentState != RemoteDataInterfaceState::CONNECTED) return createDirectReply("agaveAppStart", RequestState::INVALID_STATE);
+    segmentedDownloadThreshold = minimumFileSize;
+    maxDownloadSegments = maxSegments;
+}
 
-    //This function is only for Agave Jobs
-    AgaveTaskGuide * guideToCheck = retriveTaskGuide(jobName);
-    if (guideToCheck == nullptr)
+void AgaveHandler::setListingPageParams(int pageSize, int pagesAhead)
+{
+    if (QThread::currentThread() != this->thread())
     {
-        qCDebug(remoteInterface, "ERROR: Agave App not configured");
-        return createDirectReply("agaveAppStart", RequestState::UNKNOWN_TASK);
+        QMetaObject::invokeMethod(this, "setListingPageParams", Qt::BlockingQueuedConnection,
+                                  Q_ARG(int, pageSize),
+                                  Q_ARG(int, pagesAhead));
+        return;
     }
-    if (guideToCheck->getRequestType() != AgaveRequestType::AGAVE_APP)
+
+    listingPageSize = pageSize;
+    listingPagesAhead = qMax(1, pagesAhead);
+}
+
+void AgaveHandler::setJobListPageSize(int pageSize)
+{
+    if (QThread::currentThread() != this->thread())
     {
-        qCDebug(remoteInterface, "ERROR: Agave App not configured as Agave App");
-        return createDirectReply("agaveAppStart", RequestState::UNKNOWN_TASK);
+        QMetaObject::invokeMethod(this, "setJobListPageSize", Qt::BlockingQueuedConnection,
+                                  Q_ARG(int, pageSize));
+        return;
     }
-    QString fullAgaveName = guideToCheck->getAgaveFullName();
-    if (fullAgaveName.isEmpty())
+
+    jobListPageSize = qMax(1, pageSize);
+}
+
+void AgaveHandler::setTaskDeadline(QString taskID, int deadlineMillis)
+{
+    if (QThread::currentThread() != this->thread())
     {
-        qCDebug(remoteInterface, "ERROR: Agave App does not have a full name");
-        return createDirectReply("agaveAppStart", RequestState::INTERNAL_ERROR);
+        QMetaObject::invokeMethod(this, "setTaskDeadline", Qt::BlockingQueuedConnection,
+                                  Q_ARG(QString, taskID),
+                                  Q_ARG(int, deadlineMillis));
+        return;
     }
-    if (!remotePathStringIsValid(remoteWorkingDir)) return createDirectReply(guideToCheck, RequestState::INVALID_PARAM);
 
-    QJsonDocument rawJSONinput;
-    QJsonObject rootObject;
-    rootObject.insert("appId",QJsonValue(fullAgaveName));
-    if (indivJobName.isEmpty())
+    for (AgaveTaskGuide * aGuide : taskGuideTable)
     {
-        rootObject.insert("name",QJsonValue(fullAgaveName.append("-run")));
+        if ((aGuide != nullptr) && (aGuide->getTaskID() == taskID))
+        {
+            aGuide->setDeadline(deadlineMillis);
+            return;
+        }
     }
-    else
+    qCDebug(remoteInterface, "ERROR: No task named %s to set deadline for", qPrintable(taskID));
+}
+
+void AgaveHandler::setRequestHedging(int latencyPercentile, int minimumDelayMillis)
+{
+    if (QThread::currentThread() != this->thread())
     {
-        rootObject.insert("name",QJsonValue(indivJobName));
+        QMetaObject::invokeMethod(this, "setRequestHedging", Qt::BlockingQueuedConnection,
+                                  Q_ARG(int, latencyPercentile),
+                                  Q_ARG(int, minimumDelayMillis));
+        return;
     }
 
-    if (!archivePath.isEmpty())
+    hedgePercentile = qBound(0, latencyPercentile, 99);
+    minimumHedgeDelay = qMax(0, minimumDelayMillis);
+}
+
+void AgaveHandler::setBatchConcurrency(int maxInFlight)
+{
+    if (QThread::currentThread() != this->thread())
     {
-        rootObject.insert("archivePath",QJsonValue(archivePath));
+        QMetaObject::invokeMethod(this, "setBatchConcurrency", Qt::BlockingQueuedConnection,
+                                  Q_ARG(int, maxInFlight));
+        return;
     }
 
-    QJsonObject inputList;
-    QJsonObject paramList;
+    batchConcurrency = qMax(1, maxInFlight);
+}
 
-    QStringList expectedInputs = guideToCheck->getAgaveInputList();
-    QStringList expectedParams = guideToCheck->getAgaveParamList();
+void AgaveHandler::setChunkedUploadParams(qint64 minimumFileSize, qint64 partSize)
+{
+    if (QThread::currentThread() != this->thread())
+    {
+        QMetaObject::invokeMethod(this, "setChunkedUploadParams", Qt::BlockingQueuedConnection,
+                                  Q_ARG(qint64, minimumFileSize),
+                                  Q_ARG(qint64, partSize));
+        return;
+    }
 
-    QMap<QString, QByteArray> taskVars;
-    taskVars.insert("jobName", jobName.toLatin1());
+    chunkedUploadThreshold = minimumFileSize;
+    if (partSize > 0) uploadPartSize = partSize;
+    chunkedUploadRefused = false;
+}
 
-    if ((!guideToCheck->getAgavePWDparam().isEmpty()) && (!remoteWorkingDir.isEmpty()))
+void AgaveHandler::setRequestConcurrency(int maxActive, int maxBackground, int maxBulk)
+{
+    if (QThread::currentThread() != this->thread())
     {
-        jobParameters.insert(guideToCheck->getAgavePWDparam(),remoteWorkingDir);
-        taskVars.insert("remoteWorkingDir", remoteWorkingDir.toLatin1());
+        QMetaObject::invokeMethod(this, "setRequestConcurrency", Qt::BlockingQueuedConnection,
+                                  Q_ARG(int, maxActive),
+                                  Q_ARG(int, maxBackground),
+                                  Q_ARG(int, maxBulk));
+        return;
     }
 
-    for (auto itr = jobParameters.cbegin(); itr != jobParameters.cend(); itr++)
+    maxActiveRequests = qMax(1, maxActive);
+    maxActiveByClass[static_cast<int>(AgaveRequestPriority::INTERACTIVE)] = maxActiveRequests;
+    maxActiveByClass[static_cast<int>(AgaveRequestPriority::BACKGROUND)] = qMax(1, maxBackground);
+    maxActiveByClass[static_cast<int>(AgaveRequestPriority::BULK)] = qMax(1, maxBulk);
+
+    issueQueuedRequests();
+}
+
+void AgaveHandler::setResponseCacheSize(int maxBytes)
+{
+    if (QThread::currentThread() != this->thread())
     {
-        taskVars.insert(itr.key(), (*itr).toLatin1());
+        QMetaObject::invokeMethod(this, "setResponseCacheSize", Qt::BlockingQueuedConnection,
+                                  Q_ARG(int, maxBytes));
+        return;
+    }
 
-        QJsonObject * objectToAddTo;
+    responseCache.setMaxCost(qMax(0, maxBytes));
+}
 
-        if (expectedParams.contains(itr.key()))
-        {
-            objectToAddTo = &paramList;
+void AgaveHandler::setParseOffloadSize(int minimumBytes)
+{
+    if (QThread::currentThread() != this->thread())
+    {
+        QMetaObject::invokeMethod(this, "setParseOffloadSize", Qt::BlockingQueuedConnection,
+                                  Q_ARG(int, minimumBytes));
+        return;
+    }
+
+    parseOffloadSize = minimumBytes;
+}
+
+void AgaveHandler::setCredentialStore(QString storeFileName)
+{
+    if (QThread::currentThread() != this->thread())
+    {
+        QMetaObject::invokeMethod(this, "setCredentialStore", Qt::BlockingQueuedConnection,
+                                  Q_ARG(QString, storeFileName));
+        return;
+    }
+
+    credentialStoreFile = storeFileName;
+}
+
+void AgaveHandler::setRetryBackoff(int baseDelayMillis, int maxDelayMillis)
+{
+    if (QThread::currentThread() != this->thread())
+    {
+        QMetaObject::invokeMethod(this, "setRetryBackoff", Qt::BlockingQueuedConnection,
+                                  Q_ARG(int, baseDelayMillis), Q_ARG(int, maxDelayMillis));
+        return;
+    }
+
+    baseRetryDelay = qMax(1, baseDelayMillis);
+    maxRetryDelay = qMax(baseRetryDelay, maxDelayMillis);
+}
+
+void AgaveHandler::setTlsSessionCache(QString cacheFileName)
+{
+    if (QThread::currentThread() != this->thread())
+    {
+        QMetaObject::invokeMethod(this, "setTlsSessionCache", Qt::BlockingQueuedConnection,
+                                  Q_ARG(QString, cacheFileName));
+        return;
+    }
+
+    tlsSessionCacheFile = cacheFileName;
+
+    //Qt only makes session tickets available if session persistence is on
+    SSLoptions.setSslOption(QSsl::SslOptionDisableSessionPersistence, false);
+
+    QFile cacheFile(tlsSessionCacheFile);
+    if (!cacheFile.open(QIODevice::ReadOnly)) return;
+    QJsonObject sessionRecord = QJsonDocument::fromJson(cacheFile.readAll()).object();
+
+    QDateTime ticketExpiry = QDateTime::fromString(sessionRecord.value("expires").toString(), Qt::ISODate);
+    if (!ticketExpiry.isValid() || (ticketExpiry < QDateTime::currentDateTimeUtc())) return;
+
+    SSLoptions.setSessionTicket(QByteArray::fromBase64(sessionRecord.value("ticket").toString().toLatin1()));
+}
+
+RemoteDataReply * AgaveHandler::runRemoteJob(QString jobName, ParamMap jobParameters, QString remoteWorkingDir, QString indivJobName, QString archivePath)
+{
+    if (QThread::currentThread() != this->thread())
+    {
+        return submitFromOtherThread([=]() { return runRemoteJob(jobName, jobParameters, remoteWorkingDir, indivJobName, archivePath); });
+    }
+
+    if (currentState != RemoteDataInterfaceState::CONNECTED) return createDirectReply(AgaveTaskType::AGAVE_APP_START, RequestState::INVALID_STATE);
+
+    //This function is only for Agave Jobs
+    AgaveTaskGuide * guideToCheck = retriveAppGuide(jobName);
+    if (guideToCheck == nullptr)
+    {
+        qCDebug(remoteInterface, "ERROR: Agave App not configured");
+        return createDirectReply(AgaveTaskType::AGAVE_APP_START, RequestState::UNKNOWN_TASK);
+    }
+    if (guideToCheck->getRequestType() != AgaveRequestType::AGAVE_APP)
+    {
+        qCDebug(remoteInterface, "ERROR: Agave App not configured as Agave App");
+        return createDirectReply(AgaveTaskType::AGAVE_APP_START, RequestState::UNKNOWN_TASK);
+    }
+    QString fullAgaveName = guideToCheck->getAgaveFullName();
+    if (fullAgaveName.isEmpty())
+    {
+        qCDebug(remoteInterface, "ERROR: Agave App does not have a full name");
+        return createDirectReply(AgaveTaskType::AGAVE_APP_START, RequestState::INTERNAL_ERROR);
+    }
+    if (!remotePathStringIsValid(remoteWorkingDir)) return createDirectReply(guideToCheck, RequestState::INVALID_PARAM);
+
+    QJsonDocument rawJSONinput;
+    QJsonObject rootObject;
+    rootObject.insert("appId",QJsonValue(fullAgaveName));
+    if (indivJobName.isEmpty())
+    {
+        rootObject.insert("name",QJsonValue(fullAgaveName.append("-run")));
+    }
+    else
+    {
+        rootObject.insert("name",QJsonValue(indivJobName));
+    }
+
+    if (!archivePath.isEmpty())
+    {
+        rootObject.insert("archivePath",QJsonValue(archivePath));
+    }
+
+    QJsonObject inputList;
+    QJsonObject paramList;
+
+    QStringList expectedInputs = guideToCheck->getAgaveInputList();
+    QStringList expectedParams = guideToCheck->getAgaveParamList();
+
+    QMap<QString, QByteArray> taskVars;
+    taskVars.insert("jobName", jobName.toUtf8());
+
+    if ((!guideToCheck->getAgavePWDparam().isEmpty()) && (!remoteWorkingDir.isEmpty()))
+    {
+        jobParameters.insert(guideToCheck->getAgavePWDparam(),remoteWorkingDir);
+        taskVars.insert("remoteWorkingDir", remoteWorkingDir.toUtf8());
+    }
+
+    for (auto itr = jobParameters.cbegin(); itr != jobParameters.cend(); itr++)
+    {
+        taskVars.insert(itr.key(), (*itr).toUtf8());
+
+        QJsonObject * objectToAddTo;
+
+        if (expectedParams.contains(itr.key()))
+        {
+            objectToAddTo = &paramList;
         }
         else if (expectedInputs.contains(itr.key()))
         {
@@ -521,7 +1065,7 @@ RemoteDataReply * AgaveHandler::runRemoteJob(QString jobName, ParamMap jobParame
 
     qCDebug(remoteInterface, "%s",qPrintable(rawJSONinput.toJson()));
 
-    AgaveTaskReply * theReply = performAgaveQuery("agaveAppStart", taskVars);
+    AgaveTaskReply * theReply = performAgaveQuery(AgaveTaskType::AGAVE_APP_START, taskVars);
     return qobject_cast<RemoteDataReply *>(theReply);
 }
 
@@ -529,14 +1073,10 @@ RemoteDataReply * AgaveHandler::runAgaveJob(QJsonDocument rawJobJSON)
 {
     if (QThread::currentThread() != this->thread())
     {
-        AgaveTaskReply * retVal = nullptr;
-        QMetaObject::invokeMethod(this, "runAgaveJob", Qt::BlockingQueuedConnection,
-                                  Q_RETURN_ARG(AgaveTaskReply *, retVal),
-                                  Q_ARG(QJsonDocument, rawJobJSON));
-        return retVal;
+        return submitFromOtherThread([=]() { return runAgaveJob(rawJobJSON); });
     }
 
-    if (currentState != RemoteDataInterfaceState::CONNECTED) return createDirectReply("agaveAppStart", RequestState::INVALID_STATE);
+    if (currentState != RemoteDataInterfaceState::CONNECTED) return createDirectReply(AgaveTaskType::AGAVE_APP_START, RequestState::INVALID_STATE);
 
     QMap<QString, QByteArray> taskVars;
 
@@ -545,7 +1085,7 @@ RemoteDataReply * AgaveHandler::runAgaveJob(QJsonDocument rawJobJSON)
 
     qCDebug(remoteInterface, "%s",qPrintable(rawJobJSON.toJson()));
 
-    AgaveTaskReply * theReply = performAgaveQuery("agaveAppStart", taskVars);
+    AgaveTaskReply * theReply = performAgaveQuery(AgaveTaskType::AGAVE_APP_START, taskVars);
     return qobject_cast<RemoteDataReply *>(theReply);
 }
 
@@ -553,34 +1093,41 @@ RemoteDataReply * AgaveHandler::getListOfJobs()
 {
     if (QThread::currentThread() != this->thread())
     {
-        RemoteDataReply * retVal = nullptr;
-        QMetaObject::invokeMethod(this, "getListOfJobs", Qt::BlockingQueuedConnection,
-                                  Q_RETURN_ARG(RemoteDataReply *, retVal));
-        return retVal;
+        return submitFromOtherThread([=]() { return getListOfJobs(); });
+    }
+
+    if (currentState != RemoteDataInterfaceState::CONNECTED) return createDirectReply(AgaveTaskType::GET_JOB_LIST, RequestState::INVALID_STATE);
+
+    return qobject_cast<RemoteDataReply *>(performPagedJobList(AgaveTaskType::GET_JOB_LIST, QByteArray()));
+}
+
+RemoteDataReply * AgaveHandler::getJobListChanges(QDateTime changedSince)
+{
+    if (QThread::currentThread() != this->thread())
+    {
+        return submitFromOtherThread([=]() { return getJobListChanges(changedSince); });
     }
 
-    if (currentState != RemoteDataInterfaceState::CONNECTED) return createDirectReply("getJobList", RequestState::INVALID_STATE);
+    if (!changedSince.isValid()) return createDirectReply(AgaveTaskType::GET_JOB_CHANGES, RequestState::INVALID_PARAM);
+    if (currentState != RemoteDataInterfaceState::CONNECTED) return createDirectReply(AgaveTaskType::GET_JOB_CHANGES, RequestState::INVALID_STATE);
 
-    return qobject_cast<RemoteDataReply *>(performAgaveQuery("getJobList"));
+    QByteArray sinceText = changedSince.toUTC().toString(Qt::ISODate).toUtf8();
+    return qobject_cast<RemoteDataReply *>(performPagedJobList(AgaveTaskType::GET_JOB_CHANGES, sinceText));
 }
 
 RemoteDataReply * AgaveHandler::getJobDetails(QString IDstr)
 {
     if (QThread::currentThread() != this->thread())
     {
-        RemoteDataReply * retVal = nullptr;
-        QMetaObject::invokeMethod(this, "getJobDetails", Qt::BlockingQueuedConnection,
-                                  Q_RETURN_ARG(RemoteDataReply *, retVal),
-                                  Q_ARG(QString, IDstr));
-        return retVal;
+        return submitFromOtherThread([=]() { return getJobDetails(IDstr); });
     }
 
-    if (currentState != RemoteDataInterfaceState::CONNECTED) return createDirectReply("getJobDetails", RequestState::INVALID_STATE);
+    if (currentState != RemoteDataInterfaceState::CONNECTED) return createDirectReply(AgaveTaskType::GET_JOB_DETAILS, RequestState::INVALID_STATE);
 
     QMap<QString, QByteArray> taskVars;
-    taskVars.insert("IDstr", IDstr.toLatin1());
+    taskVars.insert("IDstr", IDstr.toUtf8());
 
-    AgaveTaskReply * theReply = performAgaveQuery("getJobDetails", taskVars);
+    AgaveTaskReply * theReply = performAgaveQuery(AgaveTaskType::GET_JOB_DETAILS, taskVars);
     return qobject_cast<RemoteDataReply *>(theReply);
 }
 
@@ -588,19 +1135,15 @@ RemoteDataReply * AgaveHandler::stopJob(QString IDstr)
 {
     if (QThread::currentThread() != this->thread())
     {
-        RemoteDataReply * retVal = nullptr;
-        QMetaObject::invokeMethod(this, "stopJob", Qt::BlockingQueuedConnection,
-                                  Q_RETURN_ARG(RemoteDataReply *, retVal),
-                                  Q_ARG(QString, IDstr));
-        return retVal;
+        return submitFromOtherThread([=]() { return stopJob(IDstr); });
     }
 
-    if (currentState != RemoteDataInterfaceState::CONNECTED) return createDirectReply("stopJob", RequestState::INVALID_STATE);
+    if (currentState != RemoteDataInterfaceState::CONNECTED) return createDirectReply(AgaveTaskType::STOP_JOB, RequestState::INVALID_STATE);
 
     QMap<QString, QByteArray> taskVars;
-    taskVars.insert("IDstr", IDstr.toLatin1());
+    taskVars.insert("IDstr", IDstr.toUtf8());
 
-    AgaveTaskReply * theReply = performAgaveQuery("stopJob", taskVars);
+    AgaveTaskReply * theReply = performAgaveQuery(AgaveTaskType::STOP_JOB, taskVars);
     return qobject_cast<RemoteDataReply *>(theReply);
 }
 
@@ -608,19 +1151,15 @@ RemoteDataReply * AgaveHandler::deleteJob(QString IDstr)
 {
     if (QThread::currentThread() != this->thread())
     {
-        RemoteDataReply * retVal = nullptr;
-        QMetaObject::invokeMethod(this, "deleteJob", Qt::BlockingQueuedConnection,
-                                  Q_RETURN_ARG(RemoteDataReply *, retVal),
-                                  Q_ARG(QString, IDstr));
-        return retVal;
+        return submitFromOtherThread([=]() { return deleteJob(IDstr); });
     }
 
-    if (currentState != RemoteDataInterfaceState::CONNECTED) return createDirectReply("deleteJob", RequestState::INVALID_STATE);
+    if (currentState != RemoteDataInterfaceState::CONNECTED) return createDirectReply(AgaveTaskType::DELETE_JOB, RequestState::INVALID_STATE);
 
     QMap<QString, QByteArray> taskVars;
-    taskVars.insert("IDstr", IDstr.toLatin1());
+    taskVars.insert("IDstr", IDstr.toUtf8());
 
-    AgaveTaskReply * theReply = performAgaveQuery("deleteJob", taskVars);
+    AgaveTaskReply * theReply = performAgaveQuery(AgaveTaskType::DELETE_JOB, taskVars);
     return qobject_cast<RemoteDataReply *>(theReply);
 }
 
@@ -651,7 +1190,7 @@ void AgaveHandler::registerAgaveAppInfo(QString agaveAppName, QString fullAgaveN
     }
 
     qCDebug(remoteInterface, "Registering Agave ID: %s", qPrintable(fullAgaveName));
-    AgaveTaskGuide * toInsert = new AgaveTaskGuide(agaveAppName, AgaveRequestType::AGAVE_APP);
+    AgaveTaskGuide * toInsert = new AgaveTaskGuide(agaveAppName, AgaveTaskType::REGISTERED_APP, AgaveRequestType::AGAVE_APP);
     toInsert->setAgaveFullName(fullAgaveName);
     toInsert->setAgaveParamList(parameterList);
     toInsert->setAgaveInputList(inputList);
@@ -663,10 +1202,7 @@ RemoteDataReply * AgaveHandler::closeAllConnections()
 {
     if (QThread::currentThread() != this->thread())
     {
-        RemoteDataReply * retVal = nullptr;
-        QMetaObject::invokeMethod(this, "closeAllConnections", Qt::BlockingQueuedConnection,
-                                  Q_RETURN_ARG(RemoteDataReply *, retVal));
-        return retVal;
+        return submitFromOtherThread([=]() { return closeAllConnections(); });
     }
 
     if ((currentState == RemoteDataInterfaceState::INIT) || (currentState == RemoteDataInterfaceState::READY_TO_AUTH) ||
@@ -674,51 +1210,66 @@ RemoteDataReply * AgaveHandler::closeAllConnections()
     {
         qCDebug(remoteInterface, "ERROR: Logout attempted when not logged in.");
         changeAuthState(RemoteDataInterfaceState::DISCONNECTED);
-        return createDirectReply("startedLogout", RequestState::INVALID_STATE);
+        return createDirectReply(AgaveTaskType::STARTED_LOGOUT, RequestState::INVALID_STATE);
     }
 
     if ((currentState == RemoteDataInterfaceState::CANCEL_AUTH) || (currentState == RemoteDataInterfaceState::DISCONNECTING))
     {
         qCDebug(remoteInterface, "ERROR: Duplicate Logout attempts detected.");
-        return createDirectReply("startedLogout", RequestState::INVALID_STATE);
+        return createDirectReply(AgaveTaskType::STARTED_LOGOUT, RequestState::INVALID_STATE);
     }
 
     if (currentState == RemoteDataInterfaceState::AUTH_TRY)
     {
         qCDebug(remoteInterface, "Cancelling Agave Login");
         changeAuthState(RemoteDataInterfaceState::CANCEL_AUTH);
-        return createDirectReply("startedLogout", RequestState::GOOD);
+        return createDirectReply(AgaveTaskType::STARTED_LOGOUT, RequestState::GOOD);
     }
 
     if (clientEncoded.isEmpty() || token.isEmpty())
     {
         qCDebug(remoteInterface, "ERROR: Logout attempted incomplete login info.");
         changeAuthState(RemoteDataInterfaceState::DISCONNECTED);
-        return createDirectReply("startedLogout", RequestState::INTERNAL_ERROR);
+        return createDirectReply(AgaveTaskType::STARTED_LOGOUT, RequestState::INTERNAL_ERROR);
     }
 
     qCDebug(remoteInterface, "Closing agave connection.");
+
+    //The tokens are about to be revoked, but the client can be used again
+    writeStoredCredentials(false);
     changeAuthState(RemoteDataInterfaceState::DISCONNECTING);
 
     QMap<QString, QByteArray> taskVars;
     taskVars.insert("token", token);
-    performAgaveQuery("authRevoke", taskVars);
+    performAgaveQuery(AgaveTaskType::AUTH_REVOKE, taskVars);
     //maybe TODO: Remove client entry?
 
     if (noPendingHttpRequests())
     {
         qCDebug(remoteInterface, "ERROR: Logout never creates revoke task");
         changeAuthState(RemoteDataInterfaceState::DISCONNECTED);
-        return createDirectReply("startedLogout", RequestState::INTERNAL_ERROR);
+        return createDirectReply(AgaveTaskType::STARTED_LOGOUT, RequestState::INTERNAL_ERROR);
     }
 
-    return createDirectReply("startedLogout", RequestState::GOOD);
+    return createDirectReply(AgaveTaskType::STARTED_LOGOUT, RequestState::GOOD);
 }
 
 void AgaveHandler::changeAuthState(RemoteDataInterfaceState newState)
 {
     currentState = newState;
 
+    if ((currentState == RemoteDataInterfaceState::CONNECTED) && loginTimer.isValid())
+    {
+        qCDebug(remoteInterface, "Connected %lld ms after login started", loginTimer.elapsed());
+        recordSessionTime("loginToConnected", loginTimer);
+    }
+
+    if (currentState != RemoteDataInterfaceState::CONNECTED)
+    {
+        tokenRefreshTimer->stop();
+        failHeldRequests();
+    }
+
     if ((currentState == RemoteDataInterfaceState::READY_TO_AUTH)
             || (currentState == RemoteDataInterfaceState::INIT)
             || (currentState == RemoteDataInterfaceState::DISCONNECTED))
@@ -730,190 +1281,335 @@ void AgaveHandler::changeAuthState(RemoteDataInterfaceState newState)
 
         authUname = "";
         authPass = "";
+        passwordSalt.clear();
+        passwordHash.clear();
         clientKey = "";
         clientSecret = "";
+
+        responseCache.clear();
     }
 
     emit connectionStateChanged(currentState);
+
+    if ((currentState == RemoteDataInterfaceState::CANCEL_AUTH) ||
+            (currentState == RemoteDataInterfaceState::DISCONNECTING) ||
+            (currentState == RemoteDataInterfaceState::DISCONNECTED))
+    {
+        if (!delayedRetries.isEmpty()) sendDueRetries();
+    }
 }
 
 void AgaveHandler::setupTaskGuideList()
 {
     AgaveTaskGuide * toInsert = nullptr;
 
-    toInsert = new AgaveTaskGuide("fullAuth", AgaveRequestType::AGAVE_NONE);
+    //Requests which should be quick are given up on if they hang, so they do not hold their place forever.
+    //Transfers, and copies and moves on the server, have no deadline, since their time depends on the size of the data.
+    //A copy or move given up on may still finish on the server, so it would be reported as failed when it was not.
+    const int authDeadline = 30 * 1000;
+    const int requestDeadline = 2 * 60 * 1000;
+
+    toInsert = new AgaveTaskGuide("fullAuth", AgaveTaskType::FULL_AUTH, AgaveRequestType::AGAVE_NONE);
     insertAgaveTaskGuide(toInsert);
 
-    toInsert = new AgaveTaskGuide("startedLogout", AgaveRequestType::AGAVE_NONE);
+    toInsert = new AgaveTaskGuide("startedLogout", AgaveTaskType::STARTED_LOGOUT, AgaveRequestType::AGAVE_NONE);
     insertAgaveTaskGuide(toInsert);
 
-    toInsert = new AgaveTaskGuide("authStep1", AgaveRequestType::AGAVE_GET);
+    toInsert = new AgaveTaskGuide("authStep1", AgaveTaskType::AUTH_STEP1, AgaveRequestType::AGAVE_GET);
     toInsert->setURLsuffix(QString("/clients/v2/%1").arg(clientName));
     toInsert->setHeaderType(AuthHeaderType::PASSWD);
     toInsert->setAsInternal();
+    toInsert->setRetryPolicy(3, true);
+    toInsert->setDeadline(authDeadline);
     insertAgaveTaskGuide(toInsert);
 
-    toInsert = new AgaveTaskGuide("authStep1a", AgaveRequestType::AGAVE_DELETE);
+    toInsert = new AgaveTaskGuide("authStep1a", AgaveTaskType::AUTH_STEP1A, AgaveRequestType::AGAVE_DELETE);
     toInsert->setURLsuffix(QString("/clients/v2/%1").arg(clientName));
     toInsert->setHeaderType(AuthHeaderType::PASSWD);
     toInsert->setAsInternal();
+    toInsert->setDeadline(authDeadline);
     insertAgaveTaskGuide(toInsert);
 
-    toInsert = new AgaveTaskGuide("authStep2", AgaveRequestType::AGAVE_POST);
+    toInsert = new AgaveTaskGuide("authStep2", AgaveTaskType::AUTH_STEP2, AgaveRequestType::AGAVE_POST);
     toInsert->setURLsuffix(QString("/clients/v2/"));
     toInsert->setHeaderType(AuthHeaderType::PASSWD);
     toInsert->setPostParams(QString("clientName=%1&description=Client ID for SimCenter Wind GUI App").arg(clientName));
     toInsert->setAsInternal();
+    toInsert->setDeadline(authDeadline);
     insertAgaveTaskGuide(toInsert);
 
-    toInsert = new AgaveTaskGuide("authStep3", AgaveRequestType::AGAVE_POST);
+    toInsert = new AgaveTaskGuide("authStep3", AgaveTaskType::AUTH_STEP3, AgaveRequestType::AGAVE_POST);
     toInsert->setURLsuffix(QString("/token"));
     toInsert->setHeaderType(AuthHeaderType::CLIENT);
     toInsert->setPostParams("username=%1&password=%2&grant_type=password&scope=PRODUCTION", {"authUname", "authPass"});
     toInsert->setTokenFormat(true);
     toInsert->setAsInternal();
+    toInsert->setRetryPolicy(3, false);
+    toInsert->setDeadline(authDeadline);
     insertAgaveTaskGuide(toInsert);
 
-    toInsert = new AgaveTaskGuide("authRefresh", AgaveRequestType::AGAVE_POST);
+    toInsert = new AgaveTaskGuide("authRefresh", AgaveTaskType::AUTH_REFRESH, AgaveRequestType::AGAVE_POST);
     toInsert->setURLsuffix(QString("/token"));
     toInsert->setHeaderType(AuthHeaderType::CLIENT);
-    toInsert->setPostParams("grant_type=refresh_token&scope=PRODUCTION&refresh_token=%1",{"token"});
+    toInsert->setPostParams("grant_type=refresh_token&scope=PRODUCTION&refresh_token=%1",{"refreshToken"});
     toInsert->setTokenFormat(true);
     toInsert->setAsInternal();
+    toInsert->setRetryPolicy(3, false);
+    toInsert->setDeadline(authDeadline);
     insertAgaveTaskGuide(toInsert);
 
-    toInsert = new AgaveTaskGuide("authRevoke", AgaveRequestType::AGAVE_POST);
+    toInsert = new AgaveTaskGuide("authRevoke", AgaveTaskType::AUTH_REVOKE, AgaveRequestType::AGAVE_POST);
     toInsert->setURLsuffix(QString("/revoke"));
     toInsert->setHeaderType(AuthHeaderType::CLIENT);
     toInsert->setPostParams("token=%1",{"token"});
     toInsert->setAsInternal();
+    toInsert->setDeadline(authDeadline);
+    insertAgaveTaskGuide(toInsert);
+
+    toInsert = new AgaveTaskGuide("dirListing", AgaveTaskType::DIR_LISTING, AgaveRequestType::AGAVE_GET);
+    toInsert->setURLsuffix((QString("/files/v2/listings/system/%1/")).arg(storageNode));
+    toInsert->setDynamicURLParams("%1",{"dirPath"});
+    toInsert->setHeaderType(AuthHeaderType::TOKEN);
+    toInsert->setAsCacheable();
+    toInsert->setRetryPolicy(4, true);
+    toInsert->setDeadline(requestDeadline);
+    toInsert->setAsHedgeable();
     insertAgaveTaskGuide(toInsert);
 
-    toInsert = new AgaveTaskGuide("dirListing", AgaveRequestType::AGAVE_GET);
+    toInsert = new AgaveTaskGuide("dirListingBatches", AgaveTaskType::DIR_LISTING_BATCHES, AgaveRequestType::AGAVE_GET);
     toInsert->setURLsuffix((QString("/files/v2/listings/system/%1/")).arg(storageNode));
     toInsert->setDynamicURLParams("%1",{"dirPath"});
     toInsert->setHeaderType(AuthHeaderType::TOKEN);
+    toInsert->setRetryPolicy(4, true);
+    toInsert->setDeadline(requestDeadline);
+    toInsert->setAsHedgeable();
+    insertAgaveTaskGuide(toInsert);
+
+    toInsert = new AgaveTaskGuide("dirPagedListing", AgaveTaskType::DIR_PAGED_LISTING, AgaveRequestType::AGAVE_NONE);
+    insertAgaveTaskGuide(toInsert);
+
+    toInsert = new AgaveTaskGuide("dirListingPage", AgaveTaskType::DIR_LISTING_PAGE, AgaveRequestType::AGAVE_GET);
+    toInsert->setURLsuffix((QString("/files/v2/listings/system/%1/")).arg(storageNode));
+    toInsert->setDynamicURLParams("%1?limit=%2&offset=%3",{"dirPath", "limit", "offset"});
+    toInsert->setHeaderType(AuthHeaderType::TOKEN);
+    toInsert->setAsInternal();
+    toInsert->setRetryPolicy(4, true);
+    toInsert->setDeadline(requestDeadline);
+    toInsert->setAsHedgeable();
+    insertAgaveTaskGuide(toInsert);
+
+    toInsert = new AgaveTaskGuide("fileUpload", AgaveTaskType::FILE_UPLOAD, AgaveRequestType::AGAVE_UPLOAD);
+    toInsert->setURLsuffix((QString("/files/v2/media/system/%1/")).arg(storageNode));
+    toInsert->setDynamicURLParams("%1",{"location"});
+    toInsert->setHeaderType(AuthHeaderType::TOKEN);
+    toInsert->setPriority(AgaveRequestPriority::BULK);
+    toInsert->setRetryPolicy(3, false);
+    insertAgaveTaskGuide(toInsert);
+
+    toInsert = new AgaveTaskGuide("fileChunkedUpload", AgaveTaskType::FILE_CHUNKED_UPLOAD, AgaveRequestType::AGAVE_NONE);
     insertAgaveTaskGuide(toInsert);
 
-    toInsert = new AgaveTaskGuide("fileUpload", AgaveRequestType::AGAVE_UPLOAD);
+    toInsert = new AgaveTaskGuide("fileUploadPart", AgaveTaskType::FILE_UPLOAD_PART, AgaveRequestType::AGAVE_UPLOAD);
     toInsert->setURLsuffix((QString("/files/v2/media/system/%1/")).arg(storageNode));
     toInsert->setDynamicURLParams("%1",{"location"});
     toInsert->setHeaderType(AuthHeaderType::TOKEN);
+    toInsert->setAsInternal();
+    toInsert->setPriority(AgaveRequestPriority::BULK);
+    toInsert->setRetryPolicy(4, true);
     insertAgaveTaskGuide(toInsert);
 
-    toInsert = new AgaveTaskGuide("fileDownload", AgaveRequestType::AGAVE_DOWNLOAD);
+    toInsert = new AgaveTaskGuide("fileDownload", AgaveTaskType::FILE_DOWNLOAD, AgaveRequestType::AGAVE_DOWNLOAD);
     toInsert->setURLsuffix((QString("/files/v2/media/system/%1/")).arg(storageNode));
     //toInsert->setURLsuffix(QString("/files/v2/media/"));
     toInsert->setDynamicURLParams("%1",{"remoteName"});
     toInsert->setHeaderType(AuthHeaderType::TOKEN);
+    toInsert->setPriority(AgaveRequestPriority::BULK);
+    toInsert->setRetryPolicy(4, true);
+    insertAgaveTaskGuide(toInsert);
+
+    toInsert = new AgaveTaskGuide("fileSegmentedDownload", AgaveTaskType::FILE_SEGMENTED_DOWNLOAD, AgaveRequestType::AGAVE_NONE);
+    insertAgaveTaskGuide(toInsert);
+
+    toInsert = new AgaveTaskGuide("fileRangeDownload", AgaveTaskType::FILE_RANGE_DOWNLOAD, AgaveRequestType::AGAVE_DOWNLOAD);
+    toInsert->setURLsuffix((QString("/files/v2/media/system/%1/")).arg(storageNode));
+    toInsert->setDynamicURLParams("%1",{"remoteName"});
+    toInsert->setHeaderType(AuthHeaderType::TOKEN);
+    toInsert->setAsInternal();
+    toInsert->setPriority(AgaveRequestPriority::BULK);
+    toInsert->setRetryPolicy(4, true);
     insertAgaveTaskGuide(toInsert);
 
-    toInsert = new AgaveTaskGuide("filePipeUpload", AgaveRequestType::AGAVE_PIPE_UPLOAD);
+    toInsert = new AgaveTaskGuide("filePipeUpload", AgaveTaskType::FILE_PIPE_UPLOAD, AgaveRequestType::AGAVE_PIPE_UPLOAD);
     toInsert->setURLsuffix((QString("/files/v2/media/system/%1/")).arg(storageNode));
     toInsert->setDynamicURLParams("%1",{"location"});
     toInsert->setHeaderType(AuthHeaderType::TOKEN);
+    toInsert->setPriority(AgaveRequestPriority::BULK);
     insertAgaveTaskGuide(toInsert);
 
-    toInsert = new AgaveTaskGuide("filePipeDownload", AgaveRequestType::AGAVE_PIPE_DOWNLOAD);
+    toInsert = new AgaveTaskGuide("filePipeDownload", AgaveTaskType::FILE_PIPE_DOWNLOAD, AgaveRequestType::AGAVE_PIPE_DOWNLOAD);
     toInsert->setURLsuffix((QString("/files/v2/media/system/%1/")).arg(storageNode));
     toInsert->setDynamicURLParams("%1",{"remoteName"});
     toInsert->setHeaderType(AuthHeaderType::TOKEN);
+    toInsert->setPriority(AgaveRequestPriority::BULK);
+    toInsert->setRetryPolicy(4, true);
     insertAgaveTaskGuide(toInsert);
 
-    toInsert = new AgaveTaskGuide("fileDelete", AgaveRequestType::AGAVE_DELETE);
+    toInsert = new AgaveTaskGuide("fileDelete", AgaveTaskType::FILE_DELETE, AgaveRequestType::AGAVE_DELETE);
     toInsert->setURLsuffix((QString("/files/v2/media/system/%1/")).arg(storageNode));
     toInsert->setDynamicURLParams("%1",{"toDelete"});
     toInsert->setHeaderType(AuthHeaderType::TOKEN);
+    toInsert->setRetryPolicy(3, true);
+    toInsert->setDeadline(requestDeadline);
     insertAgaveTaskGuide(toInsert);
 
-    toInsert = new AgaveTaskGuide("newFolder", AgaveRequestType::AGAVE_PUT);
+    toInsert = new AgaveTaskGuide("newFolder", AgaveTaskType::NEW_FOLDER, AgaveRequestType::AGAVE_PUT);
     toInsert->setURLsuffix((QString("/files/v2/media/system/%1/")).arg(storageNode));
     toInsert->setDynamicURLParams("%1",{"location"});
     toInsert->setPostParams("action=mkdir&path=%1",{"newName"});
     toInsert->setHeaderType(AuthHeaderType::TOKEN);
+    toInsert->setRetryPolicy(3, false);
+    toInsert->setDeadline(requestDeadline);
     insertAgaveTaskGuide(toInsert);
 
-    toInsert = new AgaveTaskGuide("renameFile", AgaveRequestType::AGAVE_PUT);
+    toInsert = new AgaveTaskGuide("renameFile", AgaveTaskType::RENAME_FILE, AgaveRequestType::AGAVE_PUT);
     toInsert->setURLsuffix((QString("/files/v2/media/system/%1/")).arg(storageNode));
     toInsert->setDynamicURLParams("%1",{"fullName"});
     toInsert->setPostParams("action=rename&path=%1",{"newName"});
     toInsert->setHeaderType(AuthHeaderType::TOKEN);
+    toInsert->setRetryPolicy(3, false);
+    toInsert->setDeadline(requestDeadline);
     insertAgaveTaskGuide(toInsert);
 
-    toInsert = new AgaveTaskGuide("fileCopy", AgaveRequestType::AGAVE_PUT);
+    toInsert = new AgaveTaskGuide("fileCopy", AgaveTaskType::FILE_COPY, AgaveRequestType::AGAVE_PUT);
     toInsert->setURLsuffix((QString("/files/v2/media/system/%1/")).arg(storageNode));
     toInsert->setDynamicURLParams("%1",{"from"});
     toInsert->setPostParams("action=copy&path=%1",{"to"});
     toInsert->setHeaderType(AuthHeaderType::TOKEN);
+    toInsert->setRetryPolicy(3, false);
     insertAgaveTaskGuide(toInsert);
 
-    toInsert = new AgaveTaskGuide("fileMove", AgaveRequestType::AGAVE_PUT);
+    toInsert = new AgaveTaskGuide("fileMove", AgaveTaskType::FILE_MOVE, AgaveRequestType::AGAVE_PUT);
     toInsert->setURLsuffix((QString("/files/v2/media/system/%1/")).arg(storageNode));
     toInsert->setDynamicURLParams("%1",{"from"});
     toInsert->setPostParams("action=move&path=%1",{"to"});
     toInsert->setHeaderType(AuthHeaderType::TOKEN);
+    toInsert->setRetryPolicy(3, false);
+    insertAgaveTaskGuide(toInsert);
+
+    toInsert = new AgaveTaskGuide("fileBatch", AgaveTaskType::FILE_BATCH, AgaveRequestType::AGAVE_NONE);
     insertAgaveTaskGuide(toInsert);
 
-    toInsert = new AgaveTaskGuide("agaveAppStart", AgaveRequestType::AGAVE_JSON_POST);
+    toInsert = new AgaveTaskGuide("agaveAppStart", AgaveTaskType::AGAVE_APP_START, AgaveRequestType::AGAVE_JSON_POST);
     toInsert->setURLsuffix(QString("/jobs/v2"));
     toInsert->setHeaderType(AuthHeaderType::TOKEN);
+    toInsert->setRetryPolicy(3, false);
+    toInsert->setDeadline(requestDeadline);
     insertAgaveTaskGuide(toInsert);
 
-    toInsert = new AgaveTaskGuide("getAgaveList", AgaveRequestType::AGAVE_GET);
+    toInsert = new AgaveTaskGuide("getAgaveList", AgaveTaskType::GET_AGAVE_LIST, AgaveRequestType::AGAVE_GET);
     toInsert->setURLsuffix(QString("/apps/v2"));
     toInsert->setHeaderType(AuthHeaderType::TOKEN);
+    toInsert->setRetryPolicy(4, true);
+    toInsert->setDeadline(requestDeadline);
+    insertAgaveTaskGuide(toInsert);
+
+    toInsert = new AgaveTaskGuide("getJobList", AgaveTaskType::GET_JOB_LIST, AgaveRequestType::AGAVE_NONE);
+    insertAgaveTaskGuide(toInsert);
+
+    toInsert = new AgaveTaskGuide("getJobChanges", AgaveTaskType::GET_JOB_CHANGES, AgaveRequestType::AGAVE_NONE);
+    insertAgaveTaskGuide(toInsert);
+
+    toInsert = new AgaveTaskGuide("jobListPage", AgaveTaskType::JOB_LIST_PAGE, AgaveRequestType::AGAVE_GET);
+    toInsert->setURLsuffix(QString("/jobs/v2"));
+    toInsert->setDynamicURLParams("?limit=%1&offset=%2",{"limit", "offset"});
+    toInsert->setHeaderType(AuthHeaderType::TOKEN);
+    toInsert->setAsInternal();
+    toInsert->setPriority(AgaveRequestPriority::BACKGROUND);
+    toInsert->setRetryPolicy(4, true);
+    toInsert->setDeadline(requestDeadline);
     insertAgaveTaskGuide(toInsert);
 
-    toInsert = new AgaveTaskGuide("getJobList", AgaveRequestType::AGAVE_GET);
+    toInsert = new AgaveTaskGuide("jobChangesPage", AgaveTaskType::JOB_CHANGES_PAGE, AgaveRequestType::AGAVE_GET);
     toInsert->setURLsuffix(QString("/jobs/v2"));
+    toInsert->setDynamicURLParams("?limit=%1&offset=%2&lastModified.after=%3",{"limit", "offset", "changedSince"});
     toInsert->setHeaderType(AuthHeaderType::TOKEN);
+    toInsert->setAsInternal();
+    toInsert->setPriority(AgaveRequestPriority::BACKGROUND);
+    toInsert->setRetryPolicy(4, true);
+    toInsert->setDeadline(requestDeadline);
     insertAgaveTaskGuide(toInsert);
 
-    toInsert = new AgaveTaskGuide("getJobDetails", AgaveRequestType::AGAVE_GET);
+    toInsert = new AgaveTaskGuide("getJobDetails", AgaveTaskType::GET_JOB_DETAILS, AgaveRequestType::AGAVE_GET);
     toInsert->setURLsuffix(QString("/jobs/v2/"));
     toInsert->setDynamicURLParams("%1",{"IDstr"});
     toInsert->setHeaderType(AuthHeaderType::TOKEN);
+    toInsert->setAsCacheable();
+    toInsert->setRetryPolicy(4, true);
+    toInsert->setDeadline(requestDeadline);
+    toInsert->setAsHedgeable();
     insertAgaveTaskGuide(toInsert);
 
-    toInsert = new AgaveTaskGuide("stopJob", AgaveRequestType::AGAVE_POST);
+    toInsert = new AgaveTaskGuide("stopJob", AgaveTaskType::STOP_JOB, AgaveRequestType::AGAVE_POST);
     toInsert->setURLsuffix(QString("/jobs/v2/"));
     toInsert->setDynamicURLParams("%1",{"IDstr"});
     toInsert->setPostParams("action=stop");
     toInsert->setHeaderType(AuthHeaderType::TOKEN);
+    toInsert->setRetryPolicy(3, false);
+    toInsert->setDeadline(requestDeadline);
     insertAgaveTaskGuide(toInsert);
 
-    toInsert = new AgaveTaskGuide("deleteJob", AgaveRequestType::AGAVE_DELETE);
+    toInsert = new AgaveTaskGuide("deleteJob", AgaveTaskType::DELETE_JOB, AgaveRequestType::AGAVE_DELETE);
     toInsert->setURLsuffix(QString("/jobs/v2/"));
     toInsert->setDynamicURLParams("%1",{"IDstr"});
     toInsert->setHeaderType(AuthHeaderType::TOKEN);
+    toInsert->setRetryPolicy(3, true);
+    toInsert->setDeadline(requestDeadline);
     insertAgaveTaskGuide(toInsert);
 }
 
 void AgaveHandler::insertAgaveTaskGuide(AgaveTaskGuide * newGuide)
 {
-    QString taskName = newGuide->getTaskID();
-    if (validTaskList.contains(taskName))
+    if (newGuide->getTaskType() == AgaveTaskType::REGISTERED_APP)
+    {
+        if (registeredAppIndex.contains(newGuide->getTaskID()))
+        {
+            qCDebug(remoteInterface, "ERROR: Invalid Task Guide List: Duplicate Name");
+            delete newGuide;
+            return;
+        }
+        registeredAppIndex.insert(newGuide->getTaskID(), taskGuideTable.size());
+        taskGuideTable.append(newGuide);
+        return;
+    }
+
+    int taskIndex = static_cast<int>(newGuide->getTaskType());
+    if (taskGuideTable.at(taskIndex) != nullptr)
     {
         qCDebug(remoteInterface, "ERROR: Invalid Task Guide List: Duplicate Name");
+        delete newGuide;
         return;
     }
-    validTaskList.insert(taskName,newGuide);
+    taskGuideTable[taskIndex] = newGuide;
 }
 
-AgaveTaskGuide * AgaveHandler::retriveTaskGuide(QString taskID)
+AgaveTaskGuide * AgaveHandler::retriveTaskGuide(AgaveTaskType taskType)
 {
-    AgaveTaskGuide * ret;
-    if (!validTaskList.contains(taskID))
+    AgaveTaskGuide * ret = taskGuideTable.value(static_cast<int>(taskType), nullptr);
+    if (ret == nullptr)
     {
         qCDebug(remoteInterface, "ERROR: Non-existant request requested.");
-        return nullptr;
     }
-    ret = validTaskList.value(taskID);
-    if (taskID != ret->getTaskID())
+    return ret;
+}
+
+AgaveTaskGuide * AgaveHandler::retriveAppGuide(QString appName)
+{
+    if (!registeredAppIndex.contains(appName))
     {
-        qCDebug(remoteInterface, "ERROR: Task Guide format error.");
+        qCDebug(remoteInterface, "ERROR: Non-existant request requested.");
+        return nullptr;
     }
-    return ret;
+    return taskGuideTable.at(registeredAppIndex.value(appName));
 }
 
 bool AgaveHandler::remotePathStringIsValid(QString)
@@ -947,11 +1643,25 @@ void AgaveHandler::handleInternalTask(AgaveTaskReply *agaveReply, RequestState t
         return;
     }
 
-    if (agaveReply->getTaskGuide()->getTaskID() == "authRevoke")
+    AgaveTaskType taskType = agaveReply->getTaskGuide()->getTaskType();
+
+    switch (taskType)
     {
+    case AgaveTaskType::AUTH_REVOKE:
         qCDebug(remoteInterface, "Auth revoke procedure complete");
         changeAuthState(RemoteDataInterfaceState::DISCONNECTED);
         return;
+    case AgaveTaskType::FILE_RANGE_DOWNLOAD:
+        handleDownloadSegment(agaveReply, taskState);
+        return;
+    case AgaveTaskType::DIR_LISTING_PAGE:
+        handleListingPage(agaveReply, taskState, QList<FileMetaData>());
+        return;
+    case AgaveTaskType::AUTH_REFRESH:
+        finishTokenRefresh(taskState, nullptr);
+        return;
+    default:
+        break;
     }
 
     if (taskState == RequestState::GOOD)
@@ -961,9 +1671,7 @@ void AgaveHandler::handleInternalTask(AgaveTaskReply *agaveReply, RequestState t
         return;
     }
 
-    QString taskID = agaveReply->getTaskGuide()->getTaskID();
-
-    if ((taskID == "authStep1") || (taskID == "authStep1a") || (taskID == "authStep2") || (taskID == "authStep3"))
+    if ((taskType == AgaveTaskType::AUTH_STEP1) || (taskType == AgaveTaskType::AUTH_STEP1A) || (taskType == AgaveTaskType::AUTH_STEP2) || (taskType == AgaveTaskType::AUTH_STEP3))
     {
         if (currentState == RemoteDataInterfaceState::CANCEL_AUTH)
         {
@@ -985,20 +1693,32 @@ void AgaveHandler::handleInternalTask(AgaveTaskReply * agaveReply, QNetworkReply
         return;
     }
 
-    if (agaveReply->getTaskGuide()->getTaskID() == "authRevoke")
+    if (agaveReply->getTaskGuide()->getTaskType() == AgaveTaskType::AUTH_REVOKE)
     {
         qCDebug(remoteInterface, "Auth revoke procedure complete");
         changeAuthState(RemoteDataInterfaceState::DISCONNECTED);
         return;
     }
 
+    if (agaveReply->getTaskGuide()->getTaskType() == AgaveTaskType::DIR_LISTING_PAGE)
+    {
+        readListingPage(agaveReply, rawReply);
+        return;
+    }
+
     const QByteArray replyText = rawReply->readAll();
 
     QJsonParseError parseError;
     QJsonDocument parseHandler = QJsonDocument::fromJson(replyText, &parseError);
+    AgaveTaskType taskType = agaveReply->getTaskGuide()->getTaskType();
 
     if (parseHandler.isNull())
     {
+        if (taskType == AgaveTaskType::AUTH_REFRESH)
+        {
+            finishTokenRefresh(RequestState::JSON_PARSE_ERROR, nullptr);
+            return;
+        }
         forwardReplyToParent(agaveReply, RequestState::JSON_PARSE_ERROR);
         return;
     }
@@ -1007,11 +1727,17 @@ void AgaveHandler::handleInternalTask(AgaveTaskReply * agaveReply, QNetworkReply
 
     RequestState prelimResult = AgaveTaskReply::standardSuccessFailCheck(agaveReply->getTaskGuide(), &parseHandler);
 
-    QString taskID = agaveReply->getTaskGuide()->getTaskID();
+    if (taskType == AgaveTaskType::AUTH_REFRESH)
+    {
+        finishTokenRefresh(prelimResult, &parseHandler);
+        return;
+    }
+
+    if ((taskType == AgaveTaskType::AUTH_STEP3) && (prelimResult != RequestState::GOOD) && restartAuthWithNewClient(agaveReply, &parseHandler)) return;
 
     if ((prelimResult != RequestState::GOOD) && (prelimResult != RequestState::EXPLICIT_ERROR))
     {
-        if ((taskID == "authStep1") || (taskID == "authStep1a") || (taskID == "authStep2") || (taskID == "authStep3"))
+        if ((taskType == AgaveTaskType::AUTH_STEP1) || (taskType == AgaveTaskType::AUTH_STEP1A) || (taskType == AgaveTaskType::AUTH_STEP2) || (taskType == AgaveTaskType::AUTH_STEP3))
         {
             changeAuthState(RemoteDataInterfaceState::READY_TO_AUTH);
         }
@@ -1019,7 +1745,19 @@ void AgaveHandler::handleInternalTask(AgaveTaskReply * agaveReply, QNetworkReply
         return;
     }
 
-    if (taskID == "authStep1")
+    switch (taskType)
+    {
+    case AgaveTaskType::FILE_UPLOAD_PART:
+        if (prelimResult == RequestState::GOOD)
+        {
+            handleUploadPart(agaveReply, rawReply, &parseHandler);
+        }
+        else
+        {
+            forwardReplyToParent(agaveReply, prelimResult);
+        }
+        break;
+    case AgaveTaskType::AUTH_STEP1:
     {
         if (currentState == RemoteDataInterfaceState::CANCEL_AUTH)
         {
@@ -1029,7 +1767,7 @@ void AgaveHandler::handleInternalTask(AgaveTaskReply * agaveReply, QNetworkReply
         else if (prelimResult == RequestState::GOOD)
         {
             QMap<QString, QByteArray> varList;
-            performAgaveQuery("authStep1a", varList, qobject_cast<AgaveTaskReply *>(agaveReply->parent()));
+            performAgaveQuery(AgaveTaskType::AUTH_STEP1A, varList, qobject_cast<AgaveTaskReply *>(agaveReply->parent()));
         }
         else
         {
@@ -1037,7 +1775,7 @@ void AgaveHandler::handleInternalTask(AgaveTaskReply * agaveReply, QNetworkReply
             if (messageData == "Application not found")
             {
                 QMap<QString, QByteArray> varList;
-                performAgaveQuery("authStep2", varList, qobject_cast<AgaveTaskReply *>(agaveReply->parent()));
+                performAgaveQuery(AgaveTaskType::AUTH_STEP2, varList, qobject_cast<AgaveTaskReply *>(agaveReply->parent()));
             }
             else if (messageData == "Login failed.Please recheck the username and password and try again.")
             {
@@ -1050,21 +1788,23 @@ void AgaveHandler::handleInternalTask(AgaveTaskReply * agaveReply, QNetworkReply
                 forwardReplyToParent(agaveReply, prelimResult);
             }
         }
+        break;
     }
-    else if (taskID == "authStep1a")
+    case AgaveTaskType::AUTH_STEP1A:
     {
         if (prelimResult == RequestState::GOOD)
         {
             QMap<QString, QByteArray> varList;
-            performAgaveQuery("authStep2", varList, qobject_cast<AgaveTaskReply *>(agaveReply->parent()));
+            performAgaveQuery(AgaveTaskType::AUTH_STEP2, varList, qobject_cast<AgaveTaskReply *>(agaveReply->parent()));
         }
         else
         {
             changeAuthState(RemoteDataInterfaceState::READY_TO_AUTH);
             forwardReplyToParent(agaveReply, prelimResult);
         }
+        break;
     }
-    else if (taskID == "authStep2")
+    case AgaveTaskType::AUTH_STEP2:
     {
         if (prelimResult == RequestState::GOOD)
         {
@@ -1078,26 +1818,22 @@ void AgaveHandler::handleInternalTask(AgaveTaskReply * agaveReply, QNetworkReply
                 return;
             }
 
-            clientEncoded = "Basic ";
-            QByteArray rawAuth(clientKey.toLatin1());
-            rawAuth.append(":");
-            rawAuth.append(clientSecret);
-            clientEncoded.append(rawAuth.toBase64());
+            encodeClientCredentials();
 
             QMap<QString, QByteArray> varList;
-            varList.insert("authUname", authUname.toLatin1());
-            varList.insert("authPass", authPass.toLatin1());
+            varList.insert("authUname", authUname.toUtf8());
+            varList.insert("authPass", authPass.toUtf8());
 
-            performAgaveQuery("authStep3", varList, qobject_cast<AgaveTaskReply *>(agaveReply->parent()));
+            performAgaveQuery(AgaveTaskType::AUTH_STEP3, varList, qobject_cast<AgaveTaskReply *>(agaveReply->parent()));
         }
         else
         {
             changeAuthState(RemoteDataInterfaceState::READY_TO_AUTH);
             forwardReplyToParent(agaveReply, prelimResult);
         }
+        break;
     }
-    else if (taskID == "authStep3")
-    {
+    case AgaveTaskType::AUTH_STEP3:
         if (prelimResult == RequestState::GOOD)
         {
             token = AgaveTaskReply::retriveMainAgaveJSON(&parseHandler, "access_token").toString().toLatin1();
@@ -1113,6 +1849,8 @@ void AgaveHandler::handleInternalTask(AgaveTaskReply * agaveReply, QNetworkReply
                 tokenHeader = (QString("Bearer ").append(token)).toLatin1();
 
                 changeAuthState(RemoteDataInterfaceState::CONNECTED);
+                scheduleTokenRefresh(getTokenLifetime(&parseHandler));
+                writeStoredCredentials(true);
                 forwardReplyToParent(agaveReply, RequestState::GOOD);
                 qCDebug(remoteInterface, "Login success.");
             }
@@ -1122,91 +1860,1181 @@ void AgaveHandler::handleInternalTask(AgaveTaskReply * agaveReply, QNetworkReply
             changeAuthState(RemoteDataInterfaceState::READY_TO_AUTH);
             forwardReplyToParent(agaveReply, prelimResult);
         }
-    }
-    else if (taskID == "authRefresh")
-    {
-        qCDebug(remoteInterface, "Auth refresh occurred without being implemented.");
-        forwardReplyToParent(agaveReply, RequestState::NOT_IMPLEMENTED);
-
-        /*
-        if (prelimResult == RequestState::GOOD)
-        {
-            token = AgaveTaskReply::retriveMainAgaveJSON(&parseHandler, "access_token").toString().toLatin1();
-            refreshToken = AgaveTaskReply::retriveMainAgaveJSON(&parseHandler, "refresh_token").toString().toLatin1();
-
-            if (token.isEmpty() || refreshToken.isEmpty())
-            {
-                emit sendFatalErrorMessage("Token refresh failure.");
-                return;
-            }
-            //TODO: Will need more info here based on when, how and where refreshes are requested
-        }
-        */
-    }
-    else
-    {
+        break;
+    default:
         qCDebug(remoteInterface, "Non-existant internal request requested.");
         forwardReplyToParent(agaveReply, RequestState::UNKNOWN_TASK);
+        break;
     }
 }
 
-AgaveTaskReply * AgaveHandler::performAgaveQuery(QString queryName)
+void AgaveHandler::handleDownloadSegment(AgaveTaskReply * segmentReply, RequestState segmentState)
 {
-    QMap<QString, QByteArray> taskVars;
-    return performAgaveQuery(queryName, taskVars);
-}
+    AgaveTaskReply * parentReply = qobject_cast<AgaveTaskReply *>(segmentReply->parent());
+    if (parentReply == nullptr)
+    {
+        qCDebug(remoteInterface, "ERROR: Download segment has no parent download.");
+        return;
+    }
 
-AgaveTaskReply * AgaveHandler::performAgaveQuery(QString queryName, QMap<QString, QByteArray> varList, AgaveTaskReply * parentReq)
-{
-    //The network availabilty flag seems innacurate cross-platform
-    /*
-    if (networkHandle.networkAccessible() == QNetworkAccessManager::NotAccessible){}
-    */
+    parentReply->pendingSubtasks--;
 
-    if ((currentState == RemoteDataInterfaceState::CANCEL_AUTH) ||
-            (currentState == RemoteDataInterfaceState::DISCONNECTED) ||
-            (currentState == RemoteDataInterfaceState::DISCONNECTING))
+    if ((segmentState != RequestState::GOOD) && (parentReply->subtaskState == RequestState::GOOD))
     {
-        if (queryName != "authRevoke")
+        parentReply->subtaskState = segmentState;
+
+        //One failed segment spoils the file, so the other segments are stopped
+        for (AgaveTaskReply * aSegment : parentReply->findChildren<AgaveTaskReply *>(QString(), Qt::FindDirectChildrenOnly))
         {
-            qCDebug(remoteInterface, "Rejecting request given during shutdown.");
-            return createDirectReply(queryName, RequestState::INVALID_STATE, parentReq);
+            if ((aSegment == segmentReply) || (aSegment->myReplyObject == nullptr)) continue;
+            QMetaObject::invokeMethod(aSegment->myReplyObject, "abort", Qt::QueuedConnection);
         }
     }
 
-    AgaveTaskGuide * taskGuide = retriveTaskGuide(queryName);
+    if (parentReply->pendingSubtasks > 0) return;
 
-    if ((currentState != RemoteDataInterfaceState::CONNECTED) &&
-            (taskGuide->getHeaderType() == AuthHeaderType::TOKEN))
-    {
-        qCDebug(remoteInterface, "Rejecting request prior to connection established.");
-        return createDirectReply(taskGuide, RequestState::INVALID_STATE, parentReq);
-    }
+    QString localDest = QString::fromUtf8(parentReply->getTaskParamList()->value("localDest"));
+    parentReply->rawNoDataNoHttpTaskComplete(commitSegmentedDownload(localDest, parentReply->subtaskState));
+}
 
-    QNetworkReply * qReply = distillRequestData(taskGuide, &varList);
+RequestState AgaveHandler::commitSegmentedDownload(QString localDest, RequestState finalState)
+{
+    QFile partialFile(localDest + ".part");
 
-    if (qReply == nullptr)
+    if ((finalState == RequestState::GOOD) && !partialFile.rename(localDest))
     {
-        return createDirectReply(taskGuide, RequestState::INTERNAL_ERROR, parentReq);
+        qCDebug(remoteInterface, "ERROR: Unable to move finished download into place: %s", qPrintable(partialFile.errorString()));
+        finalState = RequestState::LOCAL_FILE_ERROR;
     }
-    pendingRequestCount++;
 
-    QObject * parentObj = qobject_cast<QObject *>(this);
-    if (parentReq != nullptr) parentObj = qobject_cast<QObject *>(parentReq);
+    //As with single downloads, a lost connection or a timeout leaves the partial file and its record, so the download can resume
+    if ((finalState == RequestState::DROPPED_CONNECTION) || (finalState == RequestState::LOST_INTERNET) ||
+            (finalState == RequestState::REQUEST_TIMEOUT))
+    {
+        qCDebug(remoteInterface, "Segmented download kept for resume: %s", qPrintable(localDest));
+        return finalState;
+    }
 
-    AgaveTaskReply * ret = new AgaveTaskReply(taskGuide,qReply,this, parentObj);
+    if (finalState != RequestState::GOOD)
+    {
+        partialFile.remove();
+    }
+    QFile::remove(localDest + ".part.info");
+    return finalState;
+}
 
-    for (auto itr = varList.cbegin(); itr != varList.cend(); itr++)
+void AgaveHandler::readListingPage(AgaveTaskReply * pageReply, QNetworkReply * rawReply)
+{
+    if (rawReply->error() != QNetworkReply::NoError)
     {
-        ret->getTaskParamList()->insert(itr.key(), *itr);
+        handleListingPage(pageReply, AgaveTaskReply::interpretNetworkError(rawReply), QList<FileMetaData>());
+        return;
     }
 
-    return ret;
+    QByteArray replyText = rawReply->readAll();
+    qCDebug(rawHTTP, "%s", qPrintable(QString::fromUtf8(replyText)));
+
+    AgaveListingParser pageParser;
+    pageParser.addData(replyText);
+    handleListingPage(pageReply, pageParser.getFinalState(), pageParser.takeNewEntries());
 }
 
-AgaveTaskReply * AgaveHandler::createDirectReply(QString theTaskType, RequestState errorState, AgaveTaskReply * parentReq)
+void AgaveHandler::handleListingPage(AgaveTaskReply * pageReply, RequestState pageState, QList<FileMetaData> pageEntries)
 {
-    return createDirectReply(retriveTaskGuide(theTaskType), errorState, parentReq);
+    AgaveTaskReply * parentReply = qobject_cast<AgaveTaskReply *>(pageReply->parent());
+    if (parentReply == nullptr)
+    {
+        qCDebug(remoteInterface, "ERROR: Listing page has no parent listing.");
+        return;
+    }
+
+    parentReply->pendingSubtasks--;
+
+    qint64 pageNum = pageReply->getTaskParamList()->value("pageNum").toLongLong();
+    qint64 pageSize = parentReply->getTaskParamList()->value("pageSize").toLongLong();
+
+    //Pages past the end, and those stopped after a failure, have nothing to add
+    bool pageWanted = (parentReply->subtaskState == RequestState::GOOD) &&
+            ((parentReply->lastListingPage < 0) || (pageNum <= parentReply->lastListingPage));
+
+    if (pageWanted && (pageState != RequestState::GOOD))
+    {
+        parentReply->subtaskState = pageState;
+        for (AgaveTaskReply * aPage : parentReply->findChildren<AgaveTaskReply *>(QString(), Qt::FindDirectChildrenOnly))
+        {
+            if ((aPage == pageReply) || (aPage->myReplyObject == nullptr)) continue;
+            QMetaObject::invokeMethod(aPage->myReplyObject, "abort", Qt::QueuedConnection);
+        }
+    }
+    else if (pageWanted)
+    {
+        //A short page is the last one, and any requested after it are stopped
+        if (pageEntries.size() < pageSize)
+        {
+            parentReply->lastListingPage = pageNum;
+            for (AgaveTaskReply * aPage : parentReply->findChildren<AgaveTaskReply *>(QString(), Qt::FindDirectChildrenOnly))
+            {
+                if ((aPage->myReplyObject == nullptr) || (aPage->getTaskParamList()->value("pageNum").toLongLong() <= pageNum)) continue;
+                QMetaObject::invokeMethod(aPage->myReplyObject, "abort", Qt::QueuedConnection);
+            }
+        }
+        else if (parentReply->lastListingPage < 0)
+        {
+            sendListingPage(parentReply);
+        }
+
+        //Pages are given out in order, so one which arrives early waits for those before it
+        parentReply->pagesWaiting.insert(pageNum, pageEntries);
+        while (parentReply->pagesWaiting.contains(parentReply->nextPageToGive))
+        {
+            parentReply->listingSoFar.append(parentReply->pagesWaiting.take(parentReply->nextPageToGive));
+            parentReply->nextPageToGive++;
+        }
+        if (parentReply->listingSoFar.size() > parentReply->listingBatchStart)
+        {
+            noteListingArrived();
+            parentReply->sendListingBatch();
+        }
+    }
+
+    if (parentReply->pendingSubtasks > 0) return;
+
+    RequestState finalState = parentReply->subtaskState;
+    if ((finalState == RequestState::GOOD) &&
+            ((parentReply->lastListingPage < 0) || (parentReply->nextPageToGive <= parentReply->lastListingPage)))
+    {
+        qCDebug(remoteInterface, "ERROR: Paged listing ended without its last page.");
+        finalState = RequestState::INTERNAL_ERROR;
+    }
+    parentReply->rawNoDataNoHttpTaskComplete(finalState);
+}
+
+void AgaveHandler::handleBatchItem(AgaveTaskReply * itemReply, RequestState itemState, FileMetaData newFileData)
+{
+    AgaveTaskReply * batchReply = qobject_cast<AgaveTaskReply *>(itemReply->parent());
+    if (batchReply == nullptr)
+    {
+        qCDebug(remoteInterface, "ERROR: Batch item has no parent batch.");
+        return;
+    }
+    batchReply->pendingSubtasks--;
+
+    int itemIndex = itemReply->getTaskParamList()->value("batchIndex").toInt();
+    if ((itemIndex < 0) || (itemIndex >= batchReply->batchResults.size())) return;
+
+    batchReply->batchResults[itemIndex].resultState = itemState;
+    batchReply->batchResults[itemIndex].newFileData = newFileData;
+    batchReply->batchItemsDone++;
+    if (itemState != RequestState::GOOD)
+    {
+        batchReply->batchItemsFailed++;
+    }
+
+    batchReply->sendBatchProgress();
+
+    if (batchReply->batchItemsDone < batchReply->batchResults.size())
+    {
+        sendBatchItems(batchReply);
+        return;
+    }
+
+    RequestState batchState = RequestState::GOOD;
+    for (const RemoteFileOpResult &aResult : batchReply->batchResults)
+    {
+        if (aResult.resultState != RequestState::GOOD)
+        {
+            batchState = aResult.resultState;
+            break;
+        }
+    }
+    batchReply->rawNoDataNoHttpTaskComplete(batchState);
+}
+
+void AgaveHandler::handleJobListPage(AgaveTaskReply * pageReply, AgaveListParse parsedPage)
+{
+    AgaveTaskReply * parentReply = qobject_cast<AgaveTaskReply *>(pageReply->parent());
+    if (parentReply == nullptr)
+    {
+        qCDebug(remoteInterface, "ERROR: Job list page has no parent list.");
+        return;
+    }
+    parentReply->pendingSubtasks--;
+
+    if (parsedPage.parseState != RequestState::GOOD)
+    {
+        parentReply->rawNoDataNoHttpTaskComplete(parsedPage.parseState);
+        return;
+    }
+
+    parentReply->jobListSoFar.append(parsedPage.jobList);
+
+    //A full page may have more after it, a short one is the last
+    qint64 pageSize = parentReply->getTaskParamList()->value("pageSize").toLongLong();
+    if (parsedPage.jobList.size() >= pageSize)
+    {
+        sendJobListPage(parentReply, pageReply->getTaskParamList()->value("offset").toLongLong() + pageSize);
+        return;
+    }
+    parentReply->rawNoDataNoHttpTaskComplete(RequestState::GOOD);
+}
+
+void AgaveHandler::retainPartialBuffer(QString remoteName, QByteArray partialData, qint64 expectedSize)
+{
+    qint64 retainedBytes = partialData.size();
+    for (auto itr = partialBufferDownloads.cbegin(); itr != partialBufferDownloads.cend(); itr++)
+    {
+        if (itr.key() == remoteName) continue;
+        retainedBytes += (*itr).second.size();
+    }
+
+    if (retainedBytes > maxRetainedBufferBytes)
+    {
+        qCDebug(remoteInterface, "Partial download of %s too large to keep for resume", qPrintable(remoteName));
+        partialBufferDownloads.remove(remoteName);
+        return;
+    }
+
+    partialBufferDownloads.insert(remoteName, qMakePair(expectedSize, partialData));
+}
+
+void AgaveHandler::noteListingRequested()
+{
+    if (firstListingRequestTimer.isValid()) return;
+    firstListingRequestTimer.start();
+}
+
+void AgaveHandler::noteListingArrived()
+{
+    if (firstListingArrived || !loginTimer.isValid()) return;
+    firstListingArrived = true;
+
+    qCDebug(remoteInterface, "First file listing %lld ms after login started", loginTimer.elapsed());
+    recordSessionTime("loginToFirstListing", loginTimer);
+    if (firstListingRequestTimer.isValid())
+    {
+        recordSessionTime("requestToFirstListing", firstListingRequestTimer);
+    }
+}
+
+void AgaveHandler::recordSessionTime(QString measureName, const QElapsedTimer &fromTimer)
+{
+    //Kept beside the task stats, as a request which only has a total time
+    AgaveRequestRecord sessionRecord;
+    sessionRecord.totalMicros = fromTimer.nsecsElapsed() / 1000;
+    requestStats->recordRequest(measureName, sessionRecord);
+}
+
+void AgaveHandler::noteTlsSession(QNetworkReply * finishedReply)
+{
+    if (tlsSessionCacheFile.isEmpty()) return;
+
+    QSslConfiguration replySSL = finishedReply->sslConfiguration();
+    QByteArray newTicket = replySSL.sessionTicket();
+    if (newTicket.isEmpty() || (newTicket == SSLoptions.sessionTicket())) return;
+
+    SSLoptions.setSessionTicket(newTicket);
+
+    int ticketLifetime = replySSL.sessionTicketLifeTimeHint();
+    if (ticketLifetime <= 0) ticketLifetime = 60 * 60;
+
+    QJsonObject sessionRecord;
+    sessionRecord.insert("ticket", QString::fromLatin1(newTicket.toBase64()));
+    sessionRecord.insert("expires", QDateTime::currentDateTimeUtc().addSecs(ticketLifetime).toString(Qt::ISODate));
+
+    QSaveFile cacheFile(tlsSessionCacheFile);
+    if (!cacheFile.open(QIODevice::WriteOnly)) return;
+
+    //A session ticket lets its holder resume the session, so only the owner may read it
+    cacheFile.setPermissions(QFileDevice::ReadOwner | QFileDevice::WriteOwner);
+    cacheFile.write(QJsonDocument(sessionRecord).toJson(QJsonDocument::Compact));
+    cacheFile.commit();
+}
+
+bool AgaveHandler::scheduleRetry(AgaveTaskReply * failedReply)
+{
+    if ((currentState == RemoteDataInterfaceState::CANCEL_AUTH) ||
+            (currentState == RemoteDataInterfaceState::DISCONNECTING) ||
+            (currentState == RemoteDataInterfaceState::DISCONNECTED))
+    {
+        return false;
+    }
+
+    failedReply->retryCount++;
+    int retryDelay = getRetryDelay(failedReply->retryCount, failedReply->myReplyObject);
+    qCDebug(remoteInterface, "Retrying %s in %d ms, after: %s", qPrintable(failedReply->getTaskGuide()->getTaskID()),
+            retryDelay, qPrintable(failedReply->myReplyObject->errorString()));
+
+    failedReply->prepareForReplay();
+
+    //The retry counts as pending, so a logout waits for it
+    pendingRequestCount++;
+    qint64 retryTime = QDateTime::currentMSecsSinceEpoch() + retryDelay;
+    delayedRetries.insert(retryTime, QPointer<AgaveTaskReply>(failedReply));
+
+    if (!retryTimer->isActive() || (retryTime <= delayedRetries.firstKey()))
+    {
+        retryTimer->start(retryDelay);
+    }
+    return true;
+}
+
+int AgaveHandler::getHedgeDelay(AgaveTaskGuide * theGuide)
+{
+    if ((hedgePercentile <= 0) || !theGuide->isHedgeable()) return -1;
+
+    //Until there are enough samples, there is no telling what is slow
+    QList<int> latencyList = recentLatencies.value(theGuide->getTaskID());
+    if (latencyList.size() < minimumLatencySamples) return -1;
+
+    std::sort(latencyList.begin(), latencyList.end());
+    int percentileDelay = latencyList.at((latencyList.size() - 1) * hedgePercentile / 100);
+    return qMax(percentileDelay, minimumHedgeDelay);
+}
+
+QNetworkReply * AgaveHandler::sendHedgeRequest(AgaveTaskReply * slowReply)
+{
+    //A hedge only takes room which no other request is waiting for
+    if (activeRequestClass.size() >= maxActiveRequests) return nullptr;
+    for (int priorityClass = 0; priorityClass < numPriorityClasses; priorityClass++)
+    {
+        if (!waitingRequests[priorityClass].isEmpty()) return nullptr;
+    }
+
+    AgaveTaskGuide * taskGuide = slowReply->getTaskGuide();
+    int priorityClass = static_cast<int>(taskGuide->getPriority());
+    if (activeRequestCount[priorityClass] >= maxActiveByClass[priorityClass]) return nullptr;
+
+    QNetworkReply * hedgeReply = distillRequestData(taskGuide, slowReply->getTaskParamList(), slowReply);
+    if (hedgeReply == nullptr) return nullptr;
+
+    qCDebug(remoteInterface, "Hedging slow request: %s", qPrintable(taskGuide->getTaskID()));
+    pendingRequestCount++;
+    activeRequestCount[priorityClass]++;
+    activeRequestClass.insert(hedgeReply, priorityClass);
+    return hedgeReply;
+}
+
+void AgaveHandler::noteRequestLatency(AgaveTaskGuide * theGuide, qint64 latencyMillis)
+{
+    if (!theGuide->isHedgeable()) return;
+
+    QList<int> &latencyList = recentLatencies[theGuide->getTaskID()];
+    latencyList.append(static_cast<int>(qMin(latencyMillis, qint64(INT_MAX))));
+    while (latencyList.size() > latencyWindowSize)
+    {
+        latencyList.removeFirst();
+    }
+}
+
+int AgaveHandler::getRetryDelay(int retryNum, QNetworkReply * failedReply)
+{
+    //The wait is random, so that clients turned away together do not all return together
+    qint64 delayLimit = qMin(qint64(maxRetryDelay), qint64(baseRetryDelay) << qMin(retryNum - 1, 20));
+    int retryDelay = QRandomGenerator::global()->bounded(static_cast<int>(delayLimit) + 1);
+
+    //A server which says when to come back is taken at its word, within our limit
+    bool haveRetryAfter = false;
+    int retryAfter = failedReply->rawHeader("Retry-After").trimmed().toInt(&haveRetryAfter);
+    if (haveRetryAfter && (retryAfter > 0))
+    {
+        retryDelay = qMax(retryDelay, static_cast<int>(qMin(qint64(retryAfter) * 1000, qint64(maxRetryDelay))));
+    }
+    return retryDelay;
+}
+
+void AgaveHandler::sendDueRetries()
+{
+    //Once shutting down, there is no point waiting, since the requests will be refused
+    bool sendAll = ((currentState == RemoteDataInterfaceState::CANCEL_AUTH) ||
+                    (currentState == RemoteDataInterfaceState::DISCONNECTING) ||
+                    (currentState == RemoteDataInterfaceState::DISCONNECTED));
+
+    qint64 timeNow = QDateTime::currentMSecsSinceEpoch();
+    while (!delayedRetries.isEmpty() && (sendAll || (delayedRetries.firstKey() <= timeNow)))
+    {
+        QPointer<AgaveTaskReply> retryReply = delayedRetries.first();
+        delayedRetries.erase(delayedRetries.begin());
+
+        if (retryReply.isNull())
+        {
+            decrementPendingRequests();
+            continue;
+        }
+        waitingRequests[static_cast<int>(retryReply->getTaskGuide()->getPriority())].enqueue(retryReply);
+    }
+
+    if (!delayedRetries.isEmpty())
+    {
+        retryTimer->start(static_cast<int>(qMax(qint64(0), delayedRetries.firstKey() - timeNow)));
+    }
+    issueQueuedRequests();
+}
+
+void AgaveHandler::holdForTokenRefresh(AgaveTaskReply * heldReply)
+{
+    heldForTokenRefresh.append(QPointer<AgaveTaskReply>(heldReply));
+
+    //If the token was refreshed while this request was out, there is already a new token to try
+    if (heldReply->sentWithToken != tokenHeader)
+    {
+        replayHeldRequests();
+        return;
+    }
+
+    //Without a refresh, no new token will come, so the held requests fail now, as the server refused them
+    if (!refreshAccessToken())
+    {
+        qCDebug(remoteInterface, "No token refresh possible, failing requests refused by server.");
+        failHeldRequests();
+    }
+}
+
+bool AgaveHandler::refreshAccessToken()
+{
+    if (tokenRefreshPending) return true;
+    if ((currentState != RemoteDataInterfaceState::CONNECTED) || refreshToken.isEmpty()) return false;
+
+    qCDebug(remoteInterface, "Refreshing access token.");
+    tokenRefreshPending = true;
+
+    QMap<QString, QByteArray> taskVars;
+    taskVars.insert("refreshToken", refreshToken);
+    performAgaveQuery(AgaveTaskType::AUTH_REFRESH, taskVars);
+    return true;
+}
+
+qint64 AgaveHandler::getTokenLifetime(QJsonDocument * tokenDoc)
+{
+    return AgaveTaskReply::retriveMainAgaveJSON(tokenDoc, "expires_in").toVariant().toLongLong();
+}
+
+void AgaveHandler::scheduleTokenRefresh(qint64 expiresIn)
+{
+    if (expiresIn <= 0) return;
+    tokenExpiry = QDateTime::currentDateTimeUtc().addSecs(expiresIn);
+
+    //The refresh is done well before expiry, so that requests already sent are not refused
+    qint64 refreshDelay = qMax(expiresIn / 2, expiresIn - 300) * 1000;
+    tokenRefreshTimer->start(static_cast<int>(qMin(refreshDelay, qint64(24 * 60 * 60 * 1000))));
+}
+
+void AgaveHandler::finishTokenRefresh(RequestState refreshState, QJsonDocument * parsedDoc)
+{
+    tokenRefreshPending = false;
+
+    if ((refreshState == RequestState::GOOD) && (parsedDoc != nullptr))
+    {
+        QByteArray newToken = AgaveTaskReply::retriveMainAgaveJSON(parsedDoc, "access_token").toString().toLatin1();
+        QByteArray newRefreshToken = AgaveTaskReply::retriveMainAgaveJSON(parsedDoc, "refresh_token").toString().toLatin1();
+
+        if (!newToken.isEmpty() && (currentState == RemoteDataInterfaceState::CONNECTED))
+        {
+            token = newToken;
+            if (!newRefreshToken.isEmpty()) refreshToken = newRefreshToken;
+            tokenHeader = (QString("Bearer ").append(token)).toLatin1();
+
+            qCDebug(remoteInterface, "Access token refreshed.");
+            scheduleTokenRefresh(getTokenLifetime(parsedDoc));
+            writeStoredCredentials(true);
+            replayHeldRequests();
+            return;
+        }
+        refreshState = RequestState::MISSING_REPLY_DATA;
+    }
+
+    qCDebug(remoteInterface, "Token refresh failed: %s", qPrintable(RemoteDataInterface::interpretRequestState(refreshState)));
+    failHeldRequests();
+}
+
+void AgaveHandler::replayHeldRequests()
+{
+    QList<QPointer<AgaveTaskReply>> toReplay = heldForTokenRefresh;
+    heldForTokenRefresh.clear();
+
+    for (QPointer<AgaveTaskReply> aReply : toReplay)
+    {
+        if (aReply.isNull()) continue;
+
+        aReply->tokenReplayed = true;
+        aReply->prepareForReplay();
+        pendingRequestCount++;
+        waitingRequests[static_cast<int>(aReply->getTaskGuide()->getPriority())].enqueue(aReply);
+    }
+    issueQueuedRequests();
+}
+
+void AgaveHandler::failHeldRequests()
+{
+    QList<QPointer<AgaveTaskReply>> toFail = heldForTokenRefresh;
+    heldForTokenRefresh.clear();
+
+    for (QPointer<AgaveTaskReply> aReply : toFail)
+    {
+        if (aReply.isNull()) continue;
+        aReply->setDelayedDatalessReply(AgaveTaskReply::interpretNetworkError(aReply->myReplyObject));
+    }
+}
+
+void AgaveHandler::encodeClientCredentials()
+{
+    clientEncoded = "Basic ";
+    QByteArray rawAuth(clientKey.toUtf8());
+    rawAuth.append(":");
+    rawAuth.append(clientSecret.toUtf8());
+    clientEncoded.append(rawAuth.toBase64());
+}
+
+bool AgaveHandler::restartAuthWithNewClient(AgaveTaskReply * agaveReply, QJsonDocument * parsedReply)
+{
+    //A stored client which the server says is invalid may have been deleted, so the full login is tried, once.
+    //Any other failure, such as a wrong password, is given back as it is.
+    if (parsedReply->object().value("error").toString() != "invalid_client") return false;
+
+    AgaveTaskReply * parentReply = qobject_cast<AgaveTaskReply *>(agaveReply->parent());
+    if (parentReply == nullptr) return false;
+    if (parentReply->getTaskParamList()->take("storedClient").isEmpty()) return false;
+    if (currentState != RemoteDataInterfaceState::AUTH_TRY) return false;
+
+    qCDebug(remoteInterface, "Stored client refused, registering client again.");
+    clientKey = "";
+    clientSecret = "";
+    clientEncoded = "";
+
+    QMap<QString, QByteArray> varList;
+    performAgaveQuery(AgaveTaskType::AUTH_STEP1, varList, parentReply);
+    return true;
+}
+
+QByteArray AgaveHandler::hashStoredPassword(QString passwd, QByteArray salt)
+{
+    //A standard slow key derivation, so that a copied store is slow to guess passwords against
+    return QPasswordDigestor::deriveKeyPbkdf2(QCryptographicHash::Sha256, passwd.toUtf8(), salt, passwordHashRounds, 32);
+}
+
+QJsonObject AgaveHandler::readStoredCredentials()
+{
+    if (credentialStoreFile.isEmpty()) return QJsonObject();
+
+    QFile storeFile(credentialStoreFile);
+    if (!storeFile.open(QIODevice::ReadOnly)) return QJsonObject();
+
+    QJsonObject allLogins = QJsonDocument::fromJson(storeFile.readAll()).object();
+    return allLogins.value(QString("%1 %2 %3").arg(tenantURL, clientName, authUname)).toObject();
+}
+
+void AgaveHandler::writeStoredCredentials(bool withTokens)
+{
+    if (credentialStoreFile.isEmpty()) return;
+    if (clientKey.isEmpty() || clientSecret.isEmpty()) return;
+
+    QJsonObject allLogins;
+    QFile oldStoreFile(credentialStoreFile);
+    if (oldStoreFile.open(QIODevice::ReadOnly))
+    {
+        allLogins = QJsonDocument::fromJson(oldStoreFile.readAll()).object();
+        oldStoreFile.close();
+    }
+
+    QJsonObject thisLogin;
+    thisLogin.insert("clientKey", clientKey);
+    thisLogin.insert("clientSecret", clientSecret);
+
+    //Tokens are kept with a salted hash of the password, and are only used again with that password
+    if (withTokens && !authPass.isEmpty())
+    {
+        //The hash is slow by design, so it is made once a login, and kept through token refreshes
+        if (passwordHash.isEmpty())
+        {
+            passwordSalt.clear();
+            for (int i = 0; i < 4; i++)
+            {
+                quint32 saltPart = QRandomGenerator::system()->generate();
+                passwordSalt.append(reinterpret_cast<const char *>(&saltPart), sizeof(saltPart));
+            }
+            passwordHash = hashStoredPassword(authPass, passwordSalt);
+        }
+        thisLogin.insert("passwordKdf", QString("pbkdf2-sha256"));
+        thisLogin.insert("passwordRounds", passwordHashRounds);
+        thisLogin.insert("passwordSalt", QString::fromLatin1(passwordSalt.toBase64()));
+        thisLogin.insert("passwordHash", QString::fromLatin1(passwordHash.toBase64()));
+        thisLogin.insert("token", QString::fromLatin1(token));
+        thisLogin.insert("refreshToken", QString::fromLatin1(refreshToken));
+        thisLogin.insert("tokenExpiry", tokenExpiry.toString(Qt::ISODate));
+    }
+    allLogins.insert(QString("%1 %2 %3").arg(tenantURL, clientName, authUname), thisLogin);
+
+    QSaveFile storeFile(credentialStoreFile);
+    if (!storeFile.open(QIODevice::WriteOnly))
+    {
+        qCDebug(remoteInterface, "ERROR: Unable to write credential store: %s", qPrintable(credentialStoreFile));
+        return;
+    }
+
+    //The client secret and tokens are as good as a password, so only the owner may read them
+    storeFile.setPermissions(QFileDevice::ReadOwner | QFileDevice::WriteOwner);
+    storeFile.write(QJsonDocument(allLogins).toJson(QJsonDocument::Compact));
+    storeFile.commit();
+}
+
+AgaveTaskReply * AgaveHandler::performAgaveQuery(AgaveTaskType queryType)
+{
+    QMap<QString, QByteArray> taskVars;
+    return performAgaveQuery(queryType, taskVars);
+}
+
+AgaveTaskReply * AgaveHandler::performAgaveQuery(AgaveTaskType queryType, QMap<QString, QByteArray> varList, AgaveTaskReply * parentReq)
+{
+    //The network availabilty flag seems innacurate cross-platform
+    /*
+    if (networkHandle.networkAccessible() == QNetworkAccessManager::NotAccessible){}
+    */
+
+    if ((currentState == RemoteDataInterfaceState::CANCEL_AUTH) ||
+            (currentState == RemoteDataInterfaceState::DISCONNECTED) ||
+            (currentState == RemoteDataInterfaceState::DISCONNECTING))
+    {
+        if (queryType != AgaveTaskType::AUTH_REVOKE)
+        {
+            qCDebug(remoteInterface, "Rejecting request given during shutdown.");
+            return createDirectReply(queryType, RequestState::INVALID_STATE, parentReq);
+        }
+    }
+
+    AgaveTaskGuide * taskGuide = retriveTaskGuide(queryType);
+
+    if ((currentState != RemoteDataInterfaceState::CONNECTED) &&
+            (taskGuide->getHeaderType() == AuthHeaderType::TOKEN))
+    {
+        qCDebug(remoteInterface, "Rejecting request prior to connection established.");
+        return createDirectReply(taskGuide, RequestState::INVALID_STATE, parentReq);
+    }
+
+    QObject * parentObj = qobject_cast<QObject *>(this);
+    if (parentReq != nullptr) parentObj = qobject_cast<QObject *>(parentReq);
+
+    //A read which is already underway, for the same data, is not asked for again
+    QByteArray sharedReadKey;
+    if ((taskGuide->getRequestType() == AgaveRequestType::AGAVE_GET) && !taskGuide->isInternal() && (parentReq == nullptr))
+    {
+        sharedReadKey = getRequestKey(taskGuide, &varList);
+
+        QPointer<AgaveTaskReply> leaderReply = sharedReadRequests.value(sharedReadKey);
+        if (!leaderReply.isNull() && leaderReply->canTakeFollowers())
+        {
+            qCDebug(remoteInterface, "Sharing in-progress request: %s", sharedReadKey.constData());
+            AgaveTaskReply * ret = new AgaveTaskReply(taskGuide, varList, this, parentObj);
+            ret->followReply(leaderReply.data());
+            return ret;
+        }
+    }
+
+    AgaveTaskReply * ret = new AgaveTaskReply(taskGuide, varList, this, parentObj);
+    pendingRequestCount++;
+
+    if (!sharedReadKey.isEmpty())
+    {
+        sharedReadRequests.insert(sharedReadKey, QPointer<AgaveTaskReply>(ret));
+    }
+
+    waitingRequests[static_cast<int>(taskGuide->getPriority())].enqueue(QPointer<AgaveTaskReply>(ret));
+    issueQueuedRequests();
+
+    return ret;
+}
+
+QByteArray AgaveHandler::getRequestKey(AgaveTaskGuide * theGuide, QMap<QString, QByteArray> * varList)
+{
+    QByteArray ret = QByteArray::number(static_cast<int>(theGuide->getTaskType()));
+    ret.append(' ');
+    ret.append(theGuide->getArgAndURLsuffix(varList));
+    return ret;
+}
+
+void AgaveHandler::storeCachedReply(QByteArray requestKey, AgaveCacheEntry * newEntry, int replySize)
+{
+    //Without a validator, the server could never tell us the entry is still good
+    if (newEntry->eTag.isEmpty() && newEntry->lastModified.isEmpty())
+    {
+        responseCache.remove(requestKey);
+        delete newEntry;
+        return;
+    }
+
+    responseCache.insert(requestKey, newEntry, qMax(1, replySize));
+}
+
+void AgaveHandler::issueQueuedRequests()
+{
+    //First, each class with requests waiting and none running gets one sent, taking turns,
+    //so that a busy higher class cannot keep a lower class waiting for good
+    for (int turnNum = 0; turnNum < numPriorityClasses; turnNum++)
+    {
+        if (activeRequestClass.size() >= maxActiveRequests) return;
+
+        int priorityClass = (firstSlotTurn + turnNum) % numPriorityClasses;
+        if (activeRequestCount[priorityClass] > 0) continue;
+        if (issueNextWaiting(priorityClass))
+        {
+            firstSlotTurn = (priorityClass + 1) % numPriorityClasses;
+        }
+    }
+
+    //Then higher priority classes go first, each in the order requested, as long as there is room
+    for (int priorityClass = 0; priorityClass < numPriorityClasses; priorityClass++)
+    {
+        while (activeRequestCount[priorityClass] < maxActiveByClass[priorityClass])
+        {
+            if (activeRequestClass.size() >= maxActiveRequests) return;
+            if (!issueNextWaiting(priorityClass)) break;
+        }
+    }
+}
+
+bool AgaveHandler::issueNextWaiting(int priorityClass)
+{
+    while (!waitingRequests[priorityClass].isEmpty())
+    {
+        QPointer<AgaveTaskReply> nextRequest = waitingRequests[priorityClass].dequeue();
+        if (nextRequest.isNull())
+        {
+            decrementPendingRequests();
+            continue;
+        }
+        issueRequest(nextRequest.data(), priorityClass);
+        return true;
+    }
+    return false;
+}
+
+void AgaveHandler::issueRequest(AgaveTaskReply * theReply, int priorityClass)
+{
+    //A request stopped while it waited has already given its reply
+    if (theReply->stopState != RequestState::GOOD)
+    {
+        decrementPendingRequests();
+        return;
+    }
+
+    AgaveTaskGuide * taskGuide = theReply->getTaskGuide();
+    RequestState rejectState = RequestState::GOOD;
+
+    //A request may have waited through a logout, or through the failure of the larger task it is part of
+    if ((currentState == RemoteDataInterfaceState::CANCEL_AUTH) ||
+            (currentState == RemoteDataInterfaceState::DISCONNECTED) ||
+            (currentState == RemoteDataInterfaceState::DISCONNECTING))
+    {
+        if (taskGuide->getTaskType() != AgaveTaskType::AUTH_REVOKE)
+        {
+            rejectState = RequestState::INVALID_STATE;
+        }
+    }
+
+    AgaveTaskReply * parentReply = qobject_cast<AgaveTaskReply *>(theReply->parent());
+    if ((parentReply != nullptr) && (parentReply->subtaskState != RequestState::GOOD))
+    {
+        rejectState = parentReply->subtaskState;
+    }
+
+    QNetworkReply * qReply = nullptr;
+    if (rejectState == RequestState::GOOD)
+    {
+        qReply = distillRequestData(taskGuide, theReply->getTaskParamList(), theReply);
+        if (qReply == nullptr) rejectState = RequestState::INTERNAL_ERROR;
+    }
+
+    if (rejectState != RequestState::GOOD)
+    {
+        theReply->setDelayedDatalessReply(rejectState);
+        decrementPendingRequests();
+        return;
+    }
+
+    activeRequestCount[priorityClass]++;
+    activeRequestClass.insert(qReply, priorityClass);
+    theReply->sentWithToken = tokenHeader;
+    theReply->attachNetworkReply(qReply);
+}
+
+AgaveTaskReply * AgaveHandler::performSegmentedDownload(QString localDest, QString remoteName, qint64 remoteSize, QJsonArray priorSegments)
+{
+    AgaveTaskGuide * parentGuide = retriveTaskGuide(AgaveTaskType::FILE_SEGMENTED_DOWNLOAD);
+
+    //As with single downloads, we do not overwrite existing files
+    if (QFile::exists(localDest)) return createDirectReply(parentGuide, RequestState::LOCAL_FILE_ERROR);
+
+    AgaveTaskReply * parentReply = new AgaveTaskReply(parentGuide, nullptr, this, qobject_cast<QObject *>(this));
+    parentReply->getTaskParamList()->insert("localDest", localDest.toUtf8());
+    parentReply->getTaskParamList()->insert("remoteName", remoteName.toUtf8());
+    parentReply->getTaskParamList()->insert("remoteSize", QByteArray::number(remoteSize));
+
+    //A resumed download takes its segments from its record, if they still fit the file
+    for (const QJsonValue &aValue : priorSegments)
+    {
+        QJsonObject aSegment = aValue.toObject();
+        qint64 rangeStart = static_cast<qint64>(aSegment.value("start").toDouble());
+        qint64 rangeEnd = static_cast<qint64>(aSegment.value("end").toDouble());
+        qint64 bytesDone = static_cast<qint64>(aSegment.value("bytesDone").toDouble());
+
+        if ((rangeStart < 0) || (rangeEnd < rangeStart) || (rangeEnd >= remoteSize) ||
+                (bytesDone < 0) || (bytesDone > rangeEnd + 1 - rangeStart))
+        {
+            qCDebug(remoteInterface, "Download record does not fit the partial file, restarting download.");
+            parentReply->segmentStarts.clear();
+            parentReply->segmentEnds.clear();
+            parentReply->segmentBytesDone.clear();
+            break;
+        }
+        parentReply->segmentStarts.append(rangeStart);
+        parentReply->segmentEnds.append(rangeEnd);
+        parentReply->segmentBytesDone.append(bytesDone);
+    }
+
+    if (parentReply->segmentStarts.isEmpty())
+    {
+        //The whole file is allocated up front, so that each segment can write at its own offset
+        QFile partialFile(localDest + ".part");
+        if (!partialFile.open(QIODevice::WriteOnly | QIODevice::Truncate) || !partialFile.resize(remoteSize))
+        {
+            partialFile.remove();
+            parentReply->deleteLater();
+            return createDirectReply(parentGuide, RequestState::LOCAL_FILE_ERROR);
+        }
+        partialFile.close();
+
+        qint64 numSegments = (remoteSize + minimumSegmentSize - 1) / minimumSegmentSize;
+        int segmentLimit = qMin(maxDownloadSegments, maxActiveByClass[static_cast<int>(AgaveRequestPriority::BULK)]);
+        numSegments = qBound(qint64(1), numSegments, qint64(segmentLimit));
+        qint64 segmentSize = (remoteSize + numSegments - 1) / numSegments;
+
+        for (qint64 rangeStart = 0; rangeStart < remoteSize; rangeStart += segmentSize)
+        {
+            parentReply->segmentStarts.append(rangeStart);
+            parentReply->segmentEnds.append(qMin(rangeStart + segmentSize, remoteSize) - 1);
+            parentReply->segmentBytesDone.append(0);
+        }
+        qCDebug(remoteInterface, "Downloading %s in %d segments", qPrintable(remoteName), parentReply->segmentStarts.size());
+    }
+    else
+    {
+        qCDebug(remoteInterface, "Resuming segmented download of %s", qPrintable(remoteName));
+    }
+    parentReply->writeSegmentRecord();
+
+    for (int i = 0; i < parentReply->segmentStarts.size(); i++)
+    {
+        qint64 rangeStart = parentReply->segmentStarts.at(i) + parentReply->segmentBytesDone.at(i);
+        qint64 rangeEnd = parentReply->segmentEnds.at(i);
+        if (rangeStart > rangeEnd) continue;
+
+        QMap<QString, QByteArray> taskVars;
+        taskVars.insert("remoteName", remoteName.toUtf8());
+        taskVars.insert("localDest", localDest.toUtf8());
+        taskVars.insert("remoteSize", QByteArray::number(remoteSize));
+        taskVars.insert("segmentNum", QByteArray::number(i));
+        taskVars.insert("rangeStart", QByteArray::number(rangeStart));
+        taskVars.insert("rangeEnd", QByteArray::number(rangeEnd));
+
+        parentReply->pendingSubtasks++;
+        performAgaveQuery(AgaveTaskType::FILE_RANGE_DOWNLOAD, taskVars, parentReply);
+    }
+
+    //Every segment may have been done before an earlier attempt failed
+    if (parentReply->pendingSubtasks == 0)
+    {
+        parentReply->setDelayedDatalessReply(commitSegmentedDownload(localDest, RequestState::GOOD));
+    }
+
+    return parentReply;
+}
+
+AgaveTaskReply * AgaveHandler::performPagedListing(QString dirPath)
+{
+    AgaveTaskGuide * parentGuide = retriveTaskGuide(AgaveTaskType::DIR_PAGED_LISTING);
+
+    AgaveTaskReply * parentReply = new AgaveTaskReply(parentGuide, nullptr, this, qobject_cast<QObject *>(this));
+    parentReply->getTaskParamList()->insert("dirPath", dirPath.toUtf8());
+    parentReply->getTaskParamList()->insert("pageSize", QByteArray::number(listingPageSize));
+
+    //The number of pages is not known, so the first few are asked for at once, and each full page asks for one more
+    for (int i = 0; i < listingPagesAhead; i++)
+    {
+        sendListingPage(parentReply);
+    }
+
+    return parentReply;
+}
+
+void AgaveHandler::sendListingPage(AgaveTaskReply * parentReply)
+{
+    QMap<QString, QByteArray> * parentParams = parentReply->getTaskParamList();
+    qint64 pageSize = parentParams->value("pageSize").toLongLong();
+    qint64 pageNum = parentReply->nextPageToSend;
+    parentReply->nextPageToSend++;
+
+    QMap<QString, QByteArray> taskVars;
+    taskVars.insert("dirPath", parentParams->value("dirPath"));
+    taskVars.insert("limit", QByteArray::number(pageSize));
+    taskVars.insert("offset", QByteArray::number(pageNum * pageSize));
+    taskVars.insert("pageNum", QByteArray::number(pageNum));
+
+    parentReply->pendingSubtasks++;
+    performAgaveQuery(AgaveTaskType::DIR_LISTING_PAGE, taskVars, parentReply);
+}
+
+void AgaveHandler::sendBatchItems(AgaveTaskReply * batchReply)
+{
+    //A stopped batch sends nothing more
+    while ((batchReply->subtaskState == RequestState::GOOD) &&
+           (batchReply->pendingSubtasks < batchConcurrency) &&
+           (batchReply->nextBatchItem < batchReply->batchResults.size()))
+    {
+        int itemIndex = batchReply->nextBatchItem;
+        batchReply->nextBatchItem++;
+
+        //Items which failed at the start are already done
+        if (batchReply->batchResults.at(itemIndex).resultState != RequestState::PENDING) continue;
+
+        QMap<QString, QByteArray> taskVars;
+        AgaveTaskType itemType = getFileOpTask(batchReply->batchResults.at(itemIndex).theOperation, &taskVars);
+
+        batchReply->pendingSubtasks++;
+        AgaveTaskReply * itemReply = performAgaveQuery(itemType, taskVars, batchReply);
+        itemReply->getTaskParamList()->insert("batchIndex", QByteArray::number(itemIndex));
+
+        switch (itemType)
+        {
+        case AgaveTaskType::FILE_DELETE:
+            QObject::connect(itemReply, SIGNAL(haveDeleteReply(RequestState,QString)),
+                             batchReply, SLOT(batchItemDone(RequestState)));
+            break;
+        case AgaveTaskType::FILE_MOVE:
+            QObject::connect(itemReply, SIGNAL(haveMoveReply(RequestState,FileMetaData,QString)),
+                             batchReply, SLOT(batchItemDone(RequestState,FileMetaData)));
+            break;
+        case AgaveTaskType::FILE_COPY:
+            QObject::connect(itemReply, SIGNAL(haveCopyReply(RequestState,FileMetaData)),
+                             batchReply, SLOT(batchItemDone(RequestState,FileMetaData)));
+            break;
+        default:
+            QObject::connect(itemReply, SIGNAL(haveRenameReply(RequestState,FileMetaData,QString)),
+                             batchReply, SLOT(batchItemDone(RequestState,FileMetaData)));
+            break;
+        }
+    }
+}
+
+AgaveTaskType AgaveHandler::getFileOpTask(const RemoteFileOperation &theOperation, QMap<QString, QByteArray> * taskVars)
+{
+    //An operation which cannot be sent is given as FILE_BATCH
+    if (!remotePathStringIsValid(theOperation.remotePath)) return AgaveTaskType::FILE_BATCH;
+
+    QMap<QString, QByteArray> unusedVars;
+    if (taskVars == nullptr) taskVars = &unusedVars;
+
+    switch (theOperation.opType)
+    {
+    case FileOperationType::REMOVE:
+        taskVars->insert("toDelete", theOperation.remotePath.toUtf8());
+        return AgaveTaskType::FILE_DELETE;
+    case FileOperationType::MOVE:
+    case FileOperationType::COPY:
+        if (!remotePathStringIsValid(theOperation.target)) return AgaveTaskType::FILE_BATCH;
+        taskVars->insert("from", theOperation.remotePath.toUtf8());
+        taskVars->insert("to", theOperation.target.toUtf8());
+        if (theOperation.opType == FileOperationType::MOVE) return AgaveTaskType::FILE_MOVE;
+        return AgaveTaskType::FILE_COPY;
+    case FileOperationType::RENAME:
+        if (theOperation.target.isEmpty()) return AgaveTaskType::FILE_BATCH;
+        taskVars->insert("fullName", theOperation.remotePath.toUtf8());
+        taskVars->insert("newName", theOperation.target.toUtf8());
+        return AgaveTaskType::RENAME_FILE;
+    }
+    return AgaveTaskType::FILE_BATCH;
+}
+
+AgaveTaskReply * AgaveHandler::performPagedJobList(AgaveTaskType listType, QByteArray changedSince)
+{
+    AgaveTaskGuide * parentGuide = retriveTaskGuide(listType);
+
+    AgaveTaskReply * parentReply = new AgaveTaskReply(parentGuide, nullptr, this, qobject_cast<QObject *>(this));
+    parentReply->getTaskParamList()->insert("pageSize", QByteArray::number(jobListPageSize));
+    if (listType == AgaveTaskType::GET_JOB_CHANGES)
+    {
+        parentReply->getTaskParamList()->insert("changedSince", changedSince);
+    }
+
+    sendJobListPage(parentReply, 0);
+    return parentReply;
+}
+
+void AgaveHandler::sendJobListPage(AgaveTaskReply * parentReply, qint64 pageOffset)
+{
+    QMap<QString, QByteArray> * parentParams = parentReply->getTaskParamList();
+
+    QMap<QString, QByteArray> taskVars;
+    taskVars.insert("limit", parentParams->value("pageSize"));
+    taskVars.insert("offset", QByteArray::number(pageOffset));
+
+    parentReply->pendingSubtasks++;
+    if (parentParams->contains("changedSince"))
+    {
+        taskVars.insert("changedSince", parentParams->value("changedSince"));
+        performAgaveQuery(AgaveTaskType::JOB_CHANGES_PAGE, taskVars, parentReply);
+    }
+    else
+    {
+        performAgaveQuery(AgaveTaskType::JOB_LIST_PAGE, taskVars, parentReply);
+    }
+}
+
+AgaveTaskReply * AgaveHandler::performChunkedUpload(QString location, QString localFileName, qint64 fileSize)
+{
+    AgaveTaskGuide * parentGuide = retriveTaskGuide(AgaveTaskType::FILE_CHUNKED_UPLOAD);
+
+    QFileInfo localFileInfo(localFileName);
+    if (!localFileInfo.isReadable()) return createDirectReply(parentGuide, RequestState::LOCAL_FILE_ERROR);
+
+    AgaveTaskReply * parentReply = new AgaveTaskReply(parentGuide, nullptr, this, qobject_cast<QObject *>(this));
+    QMap<QString, QByteArray> * parentParams = parentReply->getTaskParamList();
+    parentParams->insert("location", location.toUtf8());
+    parentParams->insert("localFileName", localFileName.toUtf8());
+    parentParams->insert("fileSize", QByteArray::number(fileSize));
+    parentParams->insert("partSize", QByteArray::number(uploadPartSize));
+    parentParams->insert("lastModified", QByteArray::number(localFileInfo.lastModified().toMSecsSinceEpoch()));
+
+    //Parts acknowledged in an earlier attempt at the same upload, of the same unchanged file, are not sent again
+    qint64 partsDone = 0;
+    QFile recordFile(localFileName + ".upload.info");
+    if (recordFile.open(QIODevice::ReadOnly))
+    {
+        QJsonObject uploadRecord = QJsonDocument::fromJson(recordFile.readAll()).object();
+        recordFile.close();
+
+        if ((uploadRecord.value("location").toString() == location) &&
+                (static_cast<qint64>(uploadRecord.value("fileSize").toDouble()) == fileSize) &&
+                (static_cast<qint64>(uploadRecord.value("partSize").toDouble()) == uploadPartSize) &&
+                (QByteArray::number(static_cast<qint64>(uploadRecord.value("lastModified").toDouble())) == parentParams->value("lastModified")))
+        {
+            partsDone = static_cast<qint64>(uploadRecord.value("partsDone").toDouble());
+        }
+    }
+
+    qint64 numParts = (fileSize + uploadPartSize - 1) / uploadPartSize;
+    if ((partsDone < 0) || (partsDone >= numParts)) partsDone = 0;
+
+    if (partsDone > 0)
+    {
+        qCDebug(remoteInterface, "Resuming upload of %s at part %lld of %lld", qPrintable(localFileName), partsDone + 1, numParts);
+    }
+    else
+    {
+        writeUploadRecord(parentReply, 0);
+    }
+
+    sendUploadPart(parentReply, partsDone);
+    return parentReply;
+}
+
+void AgaveHandler::sendUploadPart(AgaveTaskReply * parentReply, qint64 partNum)
+{
+    QMap<QString, QByteArray> * parentParams = parentReply->getTaskParamList();
+    qint64 fileSize = parentParams->value("fileSize").toLongLong();
+    qint64 partSize = parentParams->value("partSize").toLongLong();
+
+    qint64 partStart = partNum * partSize;
+    qint64 partEnd = qMin(partStart + partSize, fileSize) - 1;
+
+    QMap<QString, QByteArray> taskVars;
+    taskVars.insert("location", parentParams->value("location"));
+    taskVars.insert("localFileName", parentParams->value("localFileName"));
+    taskVars.insert("fileSize", parentParams->value("fileSize"));
+    taskVars.insert("partNum", QByteArray::number(partNum));
+    taskVars.insert("partStart", QByteArray::number(partStart));
+    taskVars.insert("partEnd", QByteArray::number(partEnd));
+
+    performAgaveQuery(AgaveTaskType::FILE_UPLOAD_PART, taskVars, parentReply);
+}
+
+void AgaveHandler::handleUploadPart(AgaveTaskReply * partReply, QNetworkReply * rawReply, QJsonDocument * parsedDoc)
+{
+    AgaveTaskReply * parentReply = qobject_cast<AgaveTaskReply *>(partReply->parent());
+    if (parentReply == nullptr)
+    {
+        qCDebug(remoteInterface, "ERROR: Upload part has no parent upload.");
+        return;
+    }
+
+    QMap<QString, QByteArray> * partParams = partReply->getTaskParamList();
+    if (partParams->contains("partStart"))
+    {
+        qint64 partsDone = partParams->value("partNum").toLongLong() + 1;
+        qint64 partEnd = partParams->value("partEnd").toLongLong();
+        qint64 fileSize = partParams->value("fileSize").toLongLong();
+
+        //A server which assembles parts acknowledges each one with how much of the file it now holds,
+        //as: Range: bytes=0-last. Agave v2 does not; it stores each part as the whole file.
+        QByteArray heldRange = rawReply->rawHeader("Range");
+        bool rangeRead = false;
+        qint64 heldEnd = -1;
+        if (heldRange.startsWith("bytes=0-")) heldEnd = heldRange.mid(8).trimmed().toLongLong(&rangeRead);
+
+        if (!rangeRead || (heldEnd != partEnd))
+        {
+            //Without that acknowledgement, parts are not used again by this handler and the file is sent whole
+            QString localFileName = QString::fromUtf8(partParams->value("localFileName"));
+            qCDebug(remoteInterface, "Server does not assemble upload parts. Uploading %s in one request.", qPrintable(localFileName));
+            chunkedUploadRefused = true;
+            QFile::remove(localFileName + ".upload.info");
+
+            QMap<QString, QByteArray> taskVars;
+            taskVars.insert("location", partParams->value("location"));
+            taskVars.insert("localFileName", partParams->value("localFileName"));
+            performAgaveQuery(AgaveTaskType::FILE_UPLOAD_PART, taskVars, parentReply);
+            return;
+        }
+
+        if (partEnd + 1 < fileSize)
+        {
+            writeUploadRecord(parentReply, partsDone);
+            sendUploadPart(parentReply, partsDone);
+            return;
+        }
+    }
+
+    //The reply to the final part, or to the whole file, describes the uploaded file
+    QFile::remove(QString::fromUtf8(parentReply->getTaskParamList()->value("localFileName")) + ".upload.info");
+
+    FileMetaData newFileData = AgaveTaskReply::parseJSONfileMetaData(AgaveTaskReply::retriveMainAgaveJSON(parsedDoc, "result").toObject());
+    if (newFileData.getFileType() == FileType::INVALID)
+    {
+        parentReply->rawNoDataNoHttpTaskComplete(RequestState::MISSING_REPLY_DATA);
+        return;
+    }
+
+    parentReply->subtaskFileResult = newFileData;
+    parentReply->rawNoDataNoHttpTaskComplete(RequestState::GOOD);
+}
+
+void AgaveHandler::writeUploadRecord(AgaveTaskReply * parentReply, qint64 partsDone)
+{
+    QMap<QString, QByteArray> * parentParams = parentReply->getTaskParamList();
+
+    QJsonObject uploadRecord;
+    uploadRecord.insert("location", QString::fromUtf8(parentParams->value("location")));
+    uploadRecord.insert("fileSize", static_cast<double>(parentParams->value("fileSize").toLongLong()));
+    uploadRecord.insert("partSize", static_cast<double>(parentParams->value("partSize").toLongLong()));
+    uploadRecord.insert("lastModified", static_cast<double>(parentParams->value("lastModified").toLongLong()));
+    uploadRecord.insert("partsDone", static_cast<double>(partsDone));
+
+    QSaveFile recordFile(QString::fromUtf8(parentParams->value("localFileName")) + ".upload.info");
+    if (!recordFile.open(QIODevice::WriteOnly)) return;
+    recordFile.write(QJsonDocument(uploadRecord).toJson(QJsonDocument::Compact));
+    recordFile.commit();
+}
+
+AgaveTaskReply * AgaveHandler::createDirectReply(AgaveTaskType theTaskType, RequestState errorState, AgaveTaskReply * parentReq)
+{
+    return createDirectReply(retriveTaskGuide(theTaskType), errorState, parentReq);
 }
 
 AgaveTaskReply * AgaveHandler::createDirectReply(AgaveTaskGuide * theTaskType, RequestState errorState, AgaveTaskReply * parentReq)
@@ -1216,7 +3044,7 @@ AgaveTaskReply * AgaveHandler::createDirectReply(AgaveTaskGuide * theTaskType, R
     return new AgaveTaskReply(theTaskType, errorState, this, parentObj);
 }
 
-QNetworkReply * AgaveHandler::distillRequestData(AgaveTaskGuide * taskGuide, QMap<QString, QByteArray> * varList)
+QNetworkReply * AgaveHandler::distillRequestData(AgaveTaskGuide * taskGuide, QMap<QString, QByteArray> * varList, AgaveTaskReply * sendingReply)
 {
     QByteArray * authHeader = nullptr;
     if (taskGuide->getHeaderType() == AuthHeaderType::CLIENT)
@@ -1236,51 +3064,104 @@ QNetworkReply * AgaveHandler::distillRequestData(AgaveTaskGuide * taskGuide, QMa
         authHeader = &tokenHeader;
     }
 
+    QByteArray urlAppend = taskGuide->getArgAndURLsuffix(varList);
+
     if ((taskGuide->getRequestType() == AgaveRequestType::AGAVE_POST) || (taskGuide->getRequestType() == AgaveRequestType::AGAVE_PUT))
     {
         //Note: For a put, the post data for this function is used as the put data for the HTTP request
-        return finalizeAgaveRequest(taskGuide, taskGuide->getArgAndURLsuffix(varList),
+        return finalizeAgaveRequest(taskGuide, urlAppend,
                          authHeader, taskGuide->fillPostArgList(varList));
     }
     else if ((taskGuide->getRequestType() == AgaveRequestType::AGAVE_GET) || (taskGuide->getRequestType() == AgaveRequestType::AGAVE_DELETE))
     {
-        qCDebug(remoteInterface, "URL Req: %s", qPrintable(taskGuide->getArgAndURLsuffix(varList)));
-        return finalizeAgaveRequest(taskGuide, taskGuide->getArgAndURLsuffix(varList),
-                         authHeader);
+        qCDebug(remoteInterface, "URL Req: %s", urlAppend.constData());
+
+        //If we have an earlier result, the server need only say that it has not changed
+        QMap<QByteArray, QByteArray> extraHeaders;
+        AgaveCacheEntry * cachedReply = nullptr;
+        if (taskGuide->isCacheable()) cachedReply = responseCache.object(getRequestKey(taskGuide, varList));
+        if (cachedReply != nullptr)
+        {
+            if (!cachedReply->eTag.isEmpty()) extraHeaders.insert("If-None-Match", cachedReply->eTag);
+            if (!cachedReply->lastModified.isEmpty()) extraHeaders.insert("If-Modified-Since", cachedReply->lastModified);
+
+            //The entry may be evicted before the server answers, so the reply keeps its own copy to give again
+            if (sendingReply != nullptr) sendingReply->keepValidatedEntry(cachedReply);
+        }
+
+        return finalizeAgaveRequest(taskGuide, urlAppend,
+                         authHeader, "", nullptr, extraHeaders);
     }
     else if (taskGuide->getRequestType() == AgaveRequestType::AGAVE_UPLOAD)
     {
         //For agave upload, instead of post params, we have the full local file name
-        QString fullFileName = QString::fromLatin1(varList->value("localFileName"));
+        QString fullFileName = QString::fromUtf8(varList->value("localFileName"));
         QFile * fileHandle = new QFile(fullFileName);
         if (!fileHandle->open(QIODevice::ReadOnly))
         {
             fileHandle->deleteLater();
             return nullptr;
         }
-        qCDebug(remoteInterface, "URL Req: %s", qPrintable(taskGuide->getArgAndURLsuffix(varList)));
+        qCDebug(remoteInterface, "URL Req: %s", urlAppend.constData());
+
+        if (!varList->contains("partStart"))
+        {
+            return finalizeAgaveRequest(taskGuide, urlAppend,
+                             authHeader, fullFileName.toUtf8(), fileHandle);
+        }
+
+        //For one part of a chunked upload, only that part of the file is read and sent
+        qint64 partStart = varList->value("partStart").toLongLong();
+        qint64 partEnd = varList->value("partEnd").toLongLong();
+
+        QBuffer * partData = new QBuffer();
+        if (!fileHandle->seek(partStart))
+        {
+            fileHandle->deleteLater();
+            partData->deleteLater();
+            return nullptr;
+        }
+        partData->setData(fileHandle->read(partEnd - partStart + 1));
+        fileHandle->deleteLater();
+
+        if (partData->size() != partEnd - partStart + 1)
+        {
+            partData->deleteLater();
+            return nullptr;
+        }
+        partData->open(QIODevice::ReadOnly);
 
-        return finalizeAgaveRequest(taskGuide, taskGuide->getArgAndURLsuffix(varList),
-                         authHeader, fullFileName.toLatin1(), fileHandle);
+        QByteArray rangeHeader = "bytes ";
+        rangeHeader.append(varList->value("partStart"));
+        rangeHeader.append("-");
+        rangeHeader.append(varList->value("partEnd"));
+        rangeHeader.append("/");
+        rangeHeader.append(varList->value("fileSize"));
+
+        QMap<QByteArray, QByteArray> extraHeaders;
+        extraHeaders.insert("Content-Range", rangeHeader);
+
+        return finalizeAgaveRequest(taskGuide, urlAppend,
+                         authHeader, fullFileName.toUtf8(), partData, extraHeaders);
     }
     else if (taskGuide->getRequestType() == AgaveRequestType::AGAVE_PIPE_UPLOAD)
     {
         qCDebug(remoteInterface, "New File Name: %s\n", qPrintable(varList->value("newFileName")));
 
+        //The buffer shares the caller's data, held by the reply, rather than copying it
         QBuffer * pipedData = new QBuffer();
-        pipedData->open(QBuffer::ReadWrite);
-        pipedData->write(varList->value("fileData"));
-        pipedData->seek(0);
+        pipedData->setData((sendingReply != nullptr) ? sendingReply->uploadData : varList->value("fileData"));
+        pipedData->open(QBuffer::ReadOnly);
 
-        qCDebug(remoteInterface, "URL Req: %s", qPrintable(taskGuide->getArgAndURLsuffix(varList)));
+        qCDebug(remoteInterface, "URL Req: %s", urlAppend.constData());
 
-        return finalizeAgaveRequest(taskGuide, taskGuide->getArgAndURLsuffix(varList),
+        return finalizeAgaveRequest(taskGuide, urlAppend,
                          authHeader, varList->value("newFileName"), pipedData);
     }
     else if (taskGuide->getRequestType() == AgaveRequestType::AGAVE_DOWNLOAD)
     {
         //For agave download, instead of post params, we have the full local file name
-        QString fullFileName = varList->value("localDest");
+        QString fullFileName = QString::fromUtf8(varList->value("localDest"));
         QFile * fileHandle = new QFile(fullFileName);
         if (fileHandle->open(QIODevice::ReadOnly))
         {
@@ -1290,18 +3171,19 @@ QNetworkReply * AgaveHandler::distillRequestData(AgaveTaskGuide * taskGuide, QMa
             return nullptr;
         }
         fileHandle->deleteLater();
-        qCDebug(remoteInterface, "URL Req: %s", qPrintable(taskGuide->getArgAndURLsuffix(varList)));
+        qCDebug(remoteInterface, "URL Req: %s", urlAppend.constData());
 
-        return finalizeAgaveRequest(taskGuide, taskGuide->getArgAndURLsuffix(varList),
-                         authHeader);
+        return finalizeAgaveRequest(taskGuide, urlAppend,
+                         authHeader, "", nullptr, getDownloadRangeHeader(varList));
     }
     else if (taskGuide->getRequestType() == AgaveRequestType::AGAVE_PIPE_DOWNLOAD)
     {
-        return finalizeAgaveRequest(taskGuide, taskGuide->getArgAndURLsuffix(varList), authHeader);
+        return finalizeAgaveRequest(taskGuide, urlAppend,
+                         authHeader, "", nullptr, getDownloadRangeHeader(varList));
     }
     else if (taskGuide->getRequestType() == AgaveRequestType::AGAVE_JSON_POST)
     {
-        return finalizeAgaveRequest(taskGuide, taskGuide->getArgAndURLsuffix(varList),
+        return finalizeAgaveRequest(taskGuide, urlAppend,
                          authHeader, varList->value("rawJSONinput"));
     }
     else
@@ -1311,15 +3193,37 @@ QNetworkReply * AgaveHandler::distillRequestData(AgaveTaskGuide * taskGuide, QMa
     }
 }
 
-QNetworkReply * AgaveHandler::finalizeAgaveRequest(AgaveTaskGuide * theGuide, QString urlAppend, QByteArray * authHeader, QByteArray postData, QIODevice * fileHandle)
+QMap<QByteArray, QByteArray> AgaveHandler::getDownloadRangeHeader(QMap<QString, QByteArray> * varList)
+{
+    QMap<QByteArray, QByteArray> extraHeaders;
+    QByteArray rangeHeader = "bytes=";
+    if (varList->contains("rangeStart"))
+    {
+        rangeHeader.append(varList->value("rangeStart"));
+        rangeHeader.append("-");
+        rangeHeader.append(varList->value("rangeEnd"));
+        extraHeaders.insert("Range", rangeHeader);
+    }
+    else if (varList->contains("resumeFrom"))
+    {
+        rangeHeader.append(varList->value("resumeFrom"));
+        rangeHeader.append("-");
+        extraHeaders.insert("Range", rangeHeader);
+    }
+    return extraHeaders;
+}
+
+QNetworkReply * AgaveHandler::finalizeAgaveRequest(AgaveTaskGuide * theGuide, QByteArray urlAppend, QByteArray * authHeader, QByteArray postData, QIODevice * fileHandle,
+                                                   QMap<QByteArray, QByteArray> extraHeaders)
 {
     QNetworkReply * clientReply = nullptr;
 
-    QString activeURL = tenantURL;
-    activeURL.append(removeDoubleSlashes(urlAppend));
+    //The task guide gives the URL already encoded, with no doubled slashes
+    QByteArray activeURL = tenantURL.toUtf8();
+    activeURL.append(urlAppend);
 
     QNetworkRequest * clientRequest = new QNetworkRequest();
-    clientRequest->setUrl(QUrl(activeURL));
+    clientRequest->setUrl(QUrl::fromEncoded(activeURL));
 
     //clientRequest->setRawHeader("User-Agent", "SimCenterWindGUI");
     if (theGuide->getRequestType() == AgaveRequestType::AGAVE_POST)
@@ -1338,14 +3242,24 @@ QNetworkReply * AgaveHandler::finalizeAgaveRequest(AgaveTaskGuide * theGuide, QS
         clientRequest->setRawHeader(QByteArray("Authorization"), *authHeader);
     }
 
+    for (auto itr = extraHeaders.cbegin(); itr != extraHeaders.cend(); itr++)
+    {
+        clientRequest->setRawHeader(itr.key(), *itr);
+    }
+
     clientRequest->setSslConfiguration(SSLoptions);
 
     qCDebug(remoteInterface, "%s", qPrintable(clientRequest->url().url()));
 
-    if ((theGuide->getRequestType() == AgaveRequestType::AGAVE_GET) || (theGuide->getRequestType() == AgaveRequestType::AGAVE_DOWNLOAD)
-            || (theGuide->getRequestType() == AgaveRequestType::AGAVE_PIPE_DOWNLOAD))
+    if ((theGuide->getRequestType() == AgaveRequestType::AGAVE_GET) || (theGuide->getRequestType() == AgaveRequestType::AGAVE_PIPE_DOWNLOAD))
+    {
+        clientReply = networkHandle->get(*clientRequest);
+    }
+    else if (theGuide->getRequestType() == AgaveRequestType::AGAVE_DOWNLOAD)
     {
         clientReply = networkHandle->get(*clientRequest);
+        //The reply is drained to disk as data arrives, so only a bounded amount is held in memory
+        clientReply->setReadBufferSize(downloadReadBufferSize);
     }
     else if (theGuide->getRequestType() == AgaveRequestType::AGAVE_POST)
     {
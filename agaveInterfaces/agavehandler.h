@@ -37,15 +37,31 @@
 #define AGAVEHANDLER_H
 
 #include "remotedatainterface.h"
+#include "agaverequeststats.h"
 
 #include <QObject>
 #include <QNetworkReply>
 #include <QHttpMultiPart>
 #include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
 #include <QBuffer>
+#include <QQueue>
+#include <QHash>
+#include <QVector>
+#include <QPointer>
+#include <QCache>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QAtomicPointer>
+#include <QMutex>
+#include <QSharedPointer>
+
+#include <functional>
 
 #include <QJsonDocument>
 #include <QJsonObject>
+#include <QJsonArray>
 
 /*! \brief The AgaveRequestType is enum intended for use internal to the AgaveHandler.
  *
@@ -54,8 +70,83 @@
 
 enum class AgaveRequestType {AGAVE_GET, AGAVE_POST, AGAVE_DELETE, AGAVE_UPLOAD, AGAVE_PIPE_UPLOAD, AGAVE_PIPE_DOWNLOAD, AGAVE_DOWNLOAD, AGAVE_PUT, AGAVE_NONE, AGAVE_APP, AGAVE_JSON_POST};
 
+/*! \brief The AgaveRequestPriority is enum intended for use internal to the AgaveHandler.
+ *
+ *  This enum gives the class of an http Agave request, which decides how the AgaveHandler schedules it.
+ */
+
+enum class AgaveRequestPriority {INTERACTIVE, BACKGROUND, BULK};
+
+/*! \brief The AgaveTaskType is enum intended for use internal to the AgaveHandler.
+ *
+ *  This enum names each task the AgaveHandler can perform, and is the index of that task's guide.
+ *  Agave apps registered by the user all have the REGISTERED_APP type, and their guides follow the built-in ones.
+ */
+
+enum class AgaveTaskType {FULL_AUTH, STARTED_LOGOUT, AUTH_STEP1, AUTH_STEP1A, AUTH_STEP2, AUTH_STEP3, AUTH_REFRESH, AUTH_REVOKE,
+                          DIR_LISTING, DIR_LISTING_BATCHES, DIR_PAGED_LISTING, DIR_LISTING_PAGE, FILE_UPLOAD, FILE_CHUNKED_UPLOAD, FILE_UPLOAD_PART, FILE_DOWNLOAD, FILE_SEGMENTED_DOWNLOAD,
+                          FILE_RANGE_DOWNLOAD, FILE_PIPE_UPLOAD, FILE_PIPE_DOWNLOAD, FILE_DELETE, NEW_FOLDER, RENAME_FILE, FILE_COPY,
+                          FILE_MOVE, FILE_BATCH, AGAVE_APP_START, GET_AGAVE_LIST, GET_JOB_LIST, GET_JOB_CHANGES, JOB_LIST_PAGE,
+                          JOB_CHANGES_PAGE, GET_JOB_DETAILS, STOP_JOB, DELETE_JOB, REGISTERED_APP};
+
 class AgaveTaskGuide;
 class AgaveTaskReply;
+class AgaveListParse;
+
+/*! \brief The AgaveCacheEntry holds the parsed result of a cacheable Agave request, for use internal to the AgaveHandler.
+ *
+ *  If the remote server says the data has not changed since the entry was made, the stored result is given again.
+ */
+
+class AgaveCacheEntry
+{
+public:
+    QByteArray eTag;
+    QByteArray lastModified;
+
+    QList<FileMetaData> fileList;
+    RemoteJobData jobData;
+};
+
+/*! \brief The AgaveHandleLink joins a reply given back to another thread to the request made for it, for use internal to the AgaveHandler.
+ *
+ *  The reply given back, the handle, stays on the caller's thread, and gets the results of the request through a relay reply beside it.
+ *  Either thread may let go first, so the link is shared, and its lock guards the pointers which cross between threads.
+ */
+
+class AgaveHandleLink
+{
+public:
+    ~AgaveHandleLink();
+
+    QMutex linkLock;
+
+    //These live on the caller's thread, and are cleared as the handle is deleted
+    AgaveTaskReply * handle = nullptr;
+    AgaveTaskReply * relay = nullptr;
+
+    //The request made on the handler's thread, which is only used from there, until it is done
+    AgaveTaskReply * madeReply = nullptr;
+    AgaveTaskGuide * madeGuide = nullptr;
+    bool requestMade = false;
+    bool requestDone = false;
+
+    //Once the handle is stopped or deleted, the request is stopped, unless another reply follows it
+    bool released = false;
+};
+
+/*! \brief The AgaveSubmission is a request made from another thread, for use internal to the AgaveHandler.
+ *
+ *  Submissions wait in a lock-free list until the AgaveHandler's thread makes the request, and links its result to the waiting handle.
+ */
+
+class AgaveSubmission
+{
+public:
+    std::function<RemoteDataReply *()> makeRequest;
+    QSharedPointer<AgaveHandleLink> handleLink;
+    AgaveSubmission * next = nullptr;
+};
 
 /*! \brief The AgaveHandler is a class for communicating with an Agave server over an https connection.
  *
@@ -75,6 +166,19 @@ public:
     explicit AgaveHandler(QNetworkAccessManager * netAccessManager, QObject * parent = nullptr);
     ~AgaveHandler();
 
+    //Moves the handler, with its own network manager, to a new thread, so that network replies and
+    //their parsing do not hold up the caller's thread. This should be done right after construction,
+    //since a connection made ahead, when the connection parameters were set, must then be made again.
+    //Afterward, the handler must be deleted with deleteLater, and its thread ends after it.
+    bool moveToOwnThread();
+
+    //Each finished request is measured: its wait in the queue, time to first byte, total time, bytes in and out,
+    //parse time and outcome. These give the histograms of those measures, by task ID, such as "dirListing".
+    //Each login also adds a total time under "loginToConnected", "loginToFirstListing", and, from the first
+    //listing asked for, "requestToFirstListing". Times are in microseconds. Both may be called from any thread.
+    QMap<QString, AgaveTaskStats> getRequestStats();
+    void resetRequestStats();
+
 public slots:
     virtual QString getUserName();
     virtual RemoteDataReply * closeAllConnections();
@@ -90,17 +194,19 @@ public slots:
     virtual RemoteDataReply * moveFile(QString from, QString to);
     virtual RemoteDataReply * copyFile(QString from, QString to);
     virtual RemoteDataReply * renameFile(QString fullName, QString newName);
+    virtual RemoteDataReply * batchFileOperations(QList<RemoteFileOperation> operationList);
 
     virtual RemoteDataReply * mkRemoteDir(QString location, QString newName);
 
     virtual RemoteDataReply * uploadFile(QString location, QString localFileName);
-    virtual RemoteDataReply * uploadBuffer(QString location, QByteArray fileData, QString newFileName);
-    virtual RemoteDataReply * downloadFile(QString localDest, QString remoteName);
+    virtual RemoteDataReply * uploadBuffer(QString location, const QByteArray &fileData, QString newFileName);
+    virtual RemoteDataReply * downloadFile(QString localDest, QString remoteName, qint64 remoteSize = -1);
     virtual RemoteDataReply * downloadBuffer(QString remoteName);
 
     virtual RemoteDataReply * runRemoteJob(QString jobName, ParamMap jobParameters, QString remoteWorkingDir, QString indivJobName = "", QString archivePath = "");
 
     virtual RemoteDataReply * getListOfJobs();
+    virtual RemoteDataReply * getJobListChanges(QDateTime changedSince);
     virtual RemoteDataReply * getJobDetails(QString IDstr);
     virtual RemoteDataReply * stopJob(QString IDstr);
     virtual RemoteDataReply * deleteJob(QString IDstr);
@@ -117,25 +223,136 @@ public slots:
     //For debugging purposes, to retrive the list of available Agave Apps:
     AgaveTaskReply *getAgaveAppList();
 
+    //Like remoteLS, but the entries are only given out through haveLSPartialReply, even for a short listing,
+    //and the whole listing is never put together. haveLSReply then ends the listing, with an empty list.
+    //Such listings are neither cached nor fetched in pages. This is for very large folders, whose entries the
+    //caller keeps as they come. The RemoteFileTree needs whole listings, so it uses remoteLS.
+    RemoteDataReply * remoteLSBatches(QString dirPath);
+
     void setAgaveConnectionParams(QString tenant, QString clientId, QString storage);
 
+    //Files of at least minimumFileSize bytes are downloaded as up to maxSegments parallel ranged requests,
+    //and never more than the number of file transfers which may be sent at once
+    void setParallelDownloadParams(qint64 minimumFileSize, int maxSegments);
+    //Files of at least minimumFileSize bytes are uploaded as a series of partSize requests, which can resume
+    //after a failure. A negative size turns this off, which is the default.
+    //Agave v2 does not assemble Content-Range parts. This is only of use with a server that does, and says so by
+    //acknowledging each part with a "Range: bytes=0-last" header. The first part not acknowledged this way is
+    //followed by an upload of the whole file, and later uploads skip parts until these settings are set again.
+    void setChunkedUploadParams(qint64 minimumFileSize, qint64 partSize);
+    //If pageSize is positive, listings are fetched as pages of that many entries, with up to pagesAhead pages
+    //requested at once. Pages are given out in order, through haveLSPartialReply, as they arrive.
+    void setListingPageParams(int pageSize, int pagesAhead);
+    //Job lists are always fetched in pages, one after another, of this many jobs
+    void setJobListPageSize(int pageSize);
+    //The items of a batch of file operations are sent at most maxInFlight at a time
+    void setBatchConcurrency(int maxInFlight);
+    //At most maxActive http requests are sent at once, of which at most maxBackground are background
+    //requests, such as job list updates, and at most maxBulk are file transfers. Interactive requests go first,
+    //but each class with requests waiting and none running gets the next free slot, so that none is starved.
+    void setRequestConcurrency(int maxActive, int maxBackground, int maxBulk);
+    //Listings and job details are kept, up to maxBytes of reply data, so that unchanged data is not sent and parsed again
+    void setResponseCacheSize(int maxBytes);
+    //Job list pages of at least minimumBytes are parsed on the global thread pool, so that several large
+    //pages are parsed at once. A negative size parses every page on the handler's thread.
+    //Listings are never parsed on the pool. They are parsed on the handler's thread, a piece at a time as
+    //their data arrives. To keep that off the GUI thread, use moveToOwnThread().
+    void setParseOffloadSize(int minimumBytes);
+    //If given, the OAuth client and tokens are kept in this file, readable only by its owner. A later login
+    //by the same user reuses them, skipping client registration, and skipping the token request if the token is still good.
+    void setCredentialStore(QString storeFileName);
+    //If given, TLS session tickets are kept in this file, so that a later process can resume the session
+    //instead of doing a full handshake. This should be set before setAgaveConnectionParams.
+    void setTlsSessionCache(QString cacheFileName);
+    //Requests which fail in a way that may pass, such as the server being too busy, are sent again, as their task allows.
+    //Answers such as refused access, a conflict or a failed TLS handshake are never sent again.
+    //The wait before each retry is random, up to a limit which starts at baseDelay and doubles with each retry, to at most maxDelay.
+    void setRetryBackoff(int baseDelayMillis, int maxDelayMillis);
+    //Changes the default deadline of one task, named by its task ID, such as "dirListing". Each try of the task
+    //is stopped, giving REQUEST_TIMEOUT, if it is not done in time. Zero removes the deadline. Since the tasks
+    //are set up by setAgaveConnectionParams, this should be called after it.
+    void setTaskDeadline(QString taskID, int deadlineMillis);
+    //Reads which are prone to slow answers, such as listings and job details, may be hedged: if a read has not
+    //answered within the given percentile of its task's recent latency, and at least minimumDelay, the same
+    //read is sent again, and the first answer is used. Only spare room is used for hedges. Zero turns this off.
+    void setRequestHedging(int latencyPercentile, int minimumDelayMillis);
+
     RemoteDataReply * runAgaveJob(QJsonDocument rawJobJSON);
 
 protected:
     void handleInternalTask(AgaveTaskReply *agaveReply, QNetworkReply * rawReply);
     void handleInternalTask(AgaveTaskReply *agaveReply, RequestState taskState);
+    void handleDownloadSegment(AgaveTaskReply *segmentReply, RequestState segmentState);
+    void retainPartialBuffer(QString remoteName, QByteArray partialData, qint64 expectedSize);
+    void handleUploadPart(AgaveTaskReply * partReply, QNetworkReply * rawReply, QJsonDocument * parsedDoc);
+    void readListingPage(AgaveTaskReply * pageReply, QNetworkReply * rawReply);
+    void handleListingPage(AgaveTaskReply * pageReply, RequestState pageState, QList<FileMetaData> pageEntries);
+    void handleJobListPage(AgaveTaskReply * pageReply, AgaveListParse parsedPage);
+    void handleBatchItem(AgaveTaskReply * itemReply, RequestState itemState, FileMetaData newFileData);
+    void storeCachedReply(QByteArray requestKey, AgaveCacheEntry * newEntry, int replySize);
+    void holdForTokenRefresh(AgaveTaskReply * heldReply);
+    void noteListingRequested();
+    void noteListingArrived();
+    void recordSessionTime(QString measureName, const QElapsedTimer &fromTimer);
+    void noteTlsSession(QNetworkReply * finishedReply);
+    bool scheduleRetry(AgaveTaskReply * failedReply);
+    int getHedgeDelay(AgaveTaskGuide * theGuide);
+    QNetworkReply * sendHedgeRequest(AgaveTaskReply * slowReply);
+    void noteRequestLatency(AgaveTaskGuide * theGuide, qint64 latencyMillis);
+
+    static QByteArray getRequestKey(AgaveTaskGuide * theGuide, QMap<QString, QByteArray> * varList);
 
 private slots:
     void finishedOneTask();
+    //Returns false if no refresh is underway, or could be started
+    bool refreshAccessToken();
+    void sendDueRetries();
+    void takeSubmittedRequests();
+    void prewarmConnection();
 
 private:
-    AgaveTaskReply * performAgaveQuery(QString queryName);
-    AgaveTaskReply * performAgaveQuery(QString queryName, QMap<QString, QByteArray> varList, AgaveTaskReply *parentReq = nullptr);
-    AgaveTaskReply * createDirectReply(AgaveTaskGuide * theTaskType, RequestState errorState, AgaveTaskReply *parentReq = nullptr);
-    AgaveTaskReply * createDirectReply(QString theTaskType, RequestState errorState, AgaveTaskReply *parentReq = nullptr);
+    AgaveTaskReply * submitFromOtherThread(std::function<RemoteDataReply *()> makeRequest);
+    void pushSubmission(AgaveSubmission * newSubmission);
 
-    QNetworkReply * distillRequestData(AgaveTaskGuide * theGuide, QMap<QString, QByteArray> * varList);
-    QNetworkReply * finalizeAgaveRequest(AgaveTaskGuide * theGuide, QString urlAppend, QByteArray * authHeader = nullptr, QByteArray postData = "", QIODevice * fileHandle = nullptr);
+    AgaveTaskReply * performAgaveQuery(AgaveTaskType queryType);
+    AgaveTaskReply * performAgaveQuery(AgaveTaskType queryType, QMap<QString, QByteArray> varList, AgaveTaskReply *parentReq = nullptr);
+    AgaveTaskReply * createDirectReply(AgaveTaskGuide * theTaskType, RequestState errorState, AgaveTaskReply *parentReq = nullptr);
+    AgaveTaskReply * createDirectReply(AgaveTaskType theTaskType, RequestState errorState, AgaveTaskReply *parentReq = nullptr);
+    AgaveTaskReply * performSegmentedDownload(QString localDest, QString remoteName, qint64 remoteSize, QJsonArray priorSegments = QJsonArray());
+    RequestState commitSegmentedDownload(QString localDest, RequestState finalState);
+    AgaveTaskReply * performChunkedUpload(QString location, QString localFileName, qint64 fileSize);
+    void sendUploadPart(AgaveTaskReply * parentReply, qint64 partNum);
+    AgaveTaskReply * performPagedListing(QString dirPath);
+    void sendListingPage(AgaveTaskReply * parentReply);
+    AgaveTaskReply * performPagedJobList(AgaveTaskType listType, QByteArray changedSince);
+    void sendJobListPage(AgaveTaskReply * parentReply, qint64 pageOffset);
+    void sendBatchItems(AgaveTaskReply * batchReply);
+    static AgaveTaskType getFileOpTask(const RemoteFileOperation &theOperation, QMap<QString, QByteArray> * taskVars);
+    static void writeUploadRecord(AgaveTaskReply * parentReply, qint64 partsDone);
+
+    void issueQueuedRequests();
+    bool issueNextWaiting(int priorityClass);
+    void issueRequest(AgaveTaskReply * theReply, int priorityClass);
+    void decrementPendingRequests();
+
+    void scheduleTokenRefresh(qint64 expiresIn);
+    static qint64 getTokenLifetime(QJsonDocument * tokenDoc);
+    void finishTokenRefresh(RequestState refreshState, QJsonDocument * parsedDoc);
+    void replayHeldRequests();
+    void failHeldRequests();
+
+    int getRetryDelay(int retryNum, QNetworkReply * failedReply);
+
+    void encodeClientCredentials();
+    bool restartAuthWithNewClient(AgaveTaskReply * agaveReply, QJsonDocument * parsedReply);
+    QJsonObject readStoredCredentials();
+    void writeStoredCredentials(bool withTokens);
+    static QByteArray hashStoredPassword(QString passwd, QByteArray salt);
+
+    QNetworkReply * distillRequestData(AgaveTaskGuide * theGuide, QMap<QString, QByteArray> * varList, AgaveTaskReply * sendingReply = nullptr);
+    QMap<QByteArray, QByteArray> getDownloadRangeHeader(QMap<QString, QByteArray> * varList);
+    QNetworkReply * finalizeAgaveRequest(AgaveTaskGuide * theGuide, QByteArray urlAppend, QByteArray * authHeader = nullptr, QByteArray postData = "", QIODevice * fileHandle = nullptr,
+                                         QMap<QByteArray, QByteArray> extraHeaders = QMap<QByteArray, QByteArray>());
 
     void forwardReplyToParent(AgaveTaskReply * agaveReply, RequestState replyState);
 
@@ -144,12 +361,14 @@ private:
 
     void setupTaskGuideList();
     void insertAgaveTaskGuide(AgaveTaskGuide * newGuide);
-    AgaveTaskGuide * retriveTaskGuide(QString taskID);
+    AgaveTaskGuide * retriveTaskGuide(AgaveTaskType taskType);
+    AgaveTaskGuide * retriveAppGuide(QString appName);
 
     static bool remotePathStringIsValid(QString toCheck);
 
     QNetworkAccessManager * networkHandle;
     QSslConfiguration SSLoptions;
+    QThread * ioThread = nullptr;
 
     QString tenantURL;
     QString clientName;
@@ -163,14 +382,90 @@ private:
 
     QString authUname;
     QString authPass;
+
+    //The salted hash of the password, kept in the credential store beside the tokens
+    static const int passwordHashRounds = 600000;
+    QByteArray passwordSalt;
+    QByteArray passwordHash;
     QString clientKey;
     QString clientSecret;
 
-    QMap<QString, AgaveTaskGuide*> validTaskList;
+    //Task guides, indexed by task type, followed by those of registered apps, which are found by name
+    QVector<AgaveTaskGuide*> taskGuideTable;
+    QHash<QString, int> registeredAppIndex;
 
     QString pwd = "";
 
     int pendingRequestCount = 0;
+
+    //Requests wait here, by priority class, until their class and the handler have room to send them
+    static const int numPriorityClasses = 3;
+    QQueue<QPointer<AgaveTaskReply>> waitingRequests[numPriorityClasses];
+    QHash<QNetworkReply *, int> activeRequestClass;
+    int activeRequestCount[numPriorityClasses] = {0, 0, 0};
+    int maxActiveByClass[numPriorityClasses] = {6, 2, 3};
+    int maxActiveRequests = 6;
+    //The class which is first in line for a slot, among those with nothing running
+    int firstSlotTurn = 0;
+
+    //Identical reads in progress share one request, by task name and URL
+    QHash<QByteArray, QPointer<AgaveTaskReply>> sharedReadRequests;
+
+    QCache<QByteArray, AgaveCacheEntry> responseCache;
+    int parseOffloadSize = 256 * 1024;
+
+    //Requests from other threads, newest first, pushed by those threads and taken all at once by this one
+    QAtomicPointer<AgaveSubmission> submittedRequests;
+
+    //The access token is refreshed before it expires, and requests refused for an expired token wait for the new one
+    QTimer * tokenRefreshTimer;
+    bool tokenRefreshPending = false;
+    QList<QPointer<AgaveTaskReply>> heldForTokenRefresh;
+    QDateTime tokenExpiry;
+
+    //Failed requests wait here, by the time they are to be sent again
+    QTimer * retryTimer;
+    QMultiMap<qint64, QPointer<AgaveTaskReply>> delayedRetries;
+    int baseRetryDelay = 500;
+    int maxRetryDelay = 30 * 1000;
+
+    //Recent latencies of hedgeable reads, by task ID, from which the wait before a hedge is found
+    int hedgePercentile = 0;
+    int minimumHedgeDelay = 200;
+    QMap<QString, QList<int>> recentLatencies;
+    const int latencyWindowSize = 64;
+    const int minimumLatencySamples = 20;
+
+    //Shared with the replies, which record themselves as they are deleted, unless the handler has gone first
+    QSharedPointer<AgaveRequestStats> requestStats;
+
+    QString credentialStoreFile;
+    QString tlsSessionCacheFile;
+
+    //Measures the time from the start of login, and from the first listing asked for, to the first file listing
+    QElapsedTimer loginTimer;
+    QElapsedTimer firstListingRequestTimer;
+    bool firstListingArrived = false;
+    const qint64 downloadReadBufferSize = 1024 * 1024;
+
+    qint64 segmentedDownloadThreshold = 64 * 1024 * 1024;
+    //No more than the bulk class can send at once, by default
+    int maxDownloadSegments = 3;
+    const qint64 minimumSegmentSize = 16 * 1024 * 1024;
+
+    qint64 chunkedUploadThreshold = -1;
+    qint64 uploadPartSize = 8 * 1024 * 1024;
+    bool chunkedUploadRefused = false;
+
+    int listingPageSize = -1;
+    int listingPagesAhead = 4;
+
+    int jobListPageSize = 100;
+    int batchConcurrency = 4;
+
+    //Data from failed buffer downloads, by remote name, kept so that a retry can resume
+    QMap<QString, QPair<qint64, QByteArray>> partialBufferDownloads;
+    const qint64 maxRetainedBufferBytes = 256 * 1024 * 1024;
     RemoteDataInterfaceState currentState = RemoteDataInterfaceState::INIT;
 };
 
@@ -0,0 +1,231 @@
+/*********************************************************************************
+**
+** Copyright (c) 2017 The University of Notre Dame
+** Copyright (c) 2017 The Regents of the University of California
+**
+** Redistribution and use in source and binary forms, with or without modification,
+** are permitted provided that the following conditions are met:
+**
+** 1. Redistributions of source code must retain the above copyright notice, this
+** list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright notice, this
+** list of conditions and the following disclaimer in the documentation and/or other
+** materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its contributors may
+** be used to endorse or promote products derived from this software without specific
+** prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+** EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+** SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+** TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+** BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+** CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+** IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+** SUCH DAMAGE.
+**
+***********************************************************************************/
+
+// Contributors:
+// Written by Peter Sempolinski, for the Natural Hazard Modeling Laboratory, director: Ahsan Kareem, at Notre Dame
+
+#include "agavelistingparser.h"
+
+#include "agavetaskreply.h"
+
+AgaveListingParser::AgaveListingParser() {}
+
+void AgaveListingParser::addData(const QByteArray &newData)
+{
+    bytesRead += newData.size();
+    if ((streamState != RequestState::GOOD) || documentDone) return;
+
+    pendingBytes.append(newData);
+    scanPendingBytes();
+
+    //Everything before an unfinished entry or key has been used, and is dropped to keep memory bounded
+    int keepFrom = scanPos;
+    if (entryStart >= 0) keepFrom = qMin(keepFrom, entryStart);
+    if (stringStart >= 0) keepFrom = qMin(keepFrom, stringStart);
+
+    pendingBytes.remove(0, keepFrom);
+    scanPos -= keepFrom;
+    if (entryStart >= 0) entryStart -= keepFrom;
+    if (stringStart >= 0) stringStart -= keepFrom;
+}
+
+QList<FileMetaData> AgaveListingParser::takeNewEntries()
+{
+    QList<FileMetaData> ret = newEntries;
+    newEntries.clear();
+    return ret;
+}
+
+RequestState AgaveListingParser::getFinalState()
+{
+    if (streamState != RequestState::GOOD) return streamState;
+    if (!documentDone) return RequestState::JSON_PARSE_ERROR;
+
+    if (statusValue == "error") return RequestState::EXPLICIT_ERROR;
+    if (statusValue != "success") return RequestState::MISSING_REPLY_STATUS;
+
+    if (!resultSeen) return RequestState::MISSING_REPLY_DATA;
+    return RequestState::GOOD;
+}
+
+qint64 AgaveListingParser::getBytesRead()
+{
+    return bytesRead;
+}
+
+void AgaveListingParser::reset()
+{
+    *this = AgaveListingParser();
+}
+
+void AgaveListingParser::scanPendingBytes()
+{
+    for ( ; scanPos < pendingBytes.size(); scanPos++)
+    {
+        if ((streamState != RequestState::GOOD) || documentDone) return;
+
+        char nextChar = pendingBytes.at(scanPos);
+
+        if (inString)
+        {
+            if (escapeNext)
+            {
+                escapeNext = false;
+            }
+            else if (nextChar == '\\')
+            {
+                escapeNext = true;
+            }
+            else if (nextChar == '"')
+            {
+                inString = false;
+                if (stringStart >= 0) finishString(scanPos);
+            }
+            continue;
+        }
+
+        switch (nextChar)
+        {
+        case '"':
+            inString = true;
+            if (depth == 1)
+            {
+                stringStart = scanPos + 1;
+            }
+            else if (inResult && (depth == 2))
+            {
+                streamState = RequestState::MISSING_REPLY_DATA;
+            }
+            break;
+        case '{':
+        case '[':
+            if (depth == 0)
+            {
+                if (nextChar != '{') streamState = RequestState::JSON_PARSE_ERROR;
+                expectKey = true;
+            }
+            else if ((depth == 1) && !expectKey && (currentKey == "result") && (nextChar == '['))
+            {
+                inResult = true;
+            }
+            else if (inResult && (depth == 2))
+            {
+                if (nextChar != '{') streamState = RequestState::MISSING_REPLY_DATA;
+                entryStart = scanPos;
+            }
+            depth++;
+            break;
+        case '}':
+        case ']':
+            depth--;
+            if (depth < 0)
+            {
+                streamState = RequestState::JSON_PARSE_ERROR;
+            }
+            else if (inResult && (depth == 2) && (entryStart >= 0))
+            {
+                finishEntry(scanPos);
+            }
+            else if (inResult && (depth == 1))
+            {
+                inResult = false;
+                resultSeen = true;
+            }
+            else if (depth == 0)
+            {
+                documentDone = true;
+            }
+            break;
+        case ',':
+            if (depth == 1)
+            {
+                expectKey = true;
+                currentKey.clear();
+            }
+            break;
+        case ':':
+            if (depth == 1) expectKey = false;
+            break;
+        case ' ':
+        case '\t':
+        case '\n':
+        case '\r':
+            break;
+        default:
+            if (depth == 0)
+            {
+                streamState = RequestState::JSON_PARSE_ERROR;
+            }
+            else if (inResult && (depth == 2))
+            {
+                streamState = RequestState::MISSING_REPLY_DATA;
+            }
+            break;
+        }
+    }
+}
+
+void AgaveListingParser::finishString(int stringEnd)
+{
+    QByteArray foundString = pendingBytes.mid(stringStart, stringEnd - stringStart);
+    stringStart = -1;
+
+    if (expectKey)
+    {
+        currentKey = foundString;
+    }
+    else if (currentKey == "status")
+    {
+        statusValue = foundString;
+    }
+}
+
+void AgaveListingParser::finishEntry(int entryEnd)
+{
+    QJsonParseError parseError;
+    QJsonDocument entryDoc = QJsonDocument::fromJson(pendingBytes.mid(entryStart, entryEnd - entryStart + 1), &parseError);
+    entryStart = -1;
+
+    if (!entryDoc.isObject())
+    {
+        streamState = RequestState::JSON_PARSE_ERROR;
+        return;
+    }
+
+    FileMetaData aFile = AgaveTaskReply::parseJSONfileMetaData(entryDoc.object());
+    if (aFile.getFileType() == FileType::INVALID)
+    {
+        streamState = RequestState::MISSING_REPLY_DATA;
+        return;
+    }
+    newEntries.append(aFile);
+}
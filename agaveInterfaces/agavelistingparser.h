@@ -0,0 +1,91 @@
+/*********************************************************************************
+**
+** Copyright (c) 2017 The University of Notre Dame
+** Copyright (c) 2017 The Regents of the University of California
+**
+** Redistribution and use in source and binary forms, with or without modification,
+** are permitted provided that the following conditions are met:
+**
+** 1. Redistributions of source code must retain the above copyright notice, this
+** list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright notice, this
+** list of conditions and the following disclaimer in the documentation and/or other
+** materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its contributors may
+** be used to endorse or promote products derived from this software without specific
+** prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+** EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+** SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+** TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+** BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+** CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+** IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+** SUCH DAMAGE.
+**
+***********************************************************************************/
+
+// Contributors:
+// Written by Peter Sempolinski, for the Natural Hazard Modeling Laboratory, director: Ahsan Kareem, at Notre Dame
+
+#ifndef AGAVELISTINGPARSER_H
+#define AGAVELISTINGPARSER_H
+
+#include "remotedatainterface.h"
+#include "filemetadata.h"
+
+#include <QByteArray>
+
+/*! \brief The AgaveListingParser reads an Agave file listing as its data arrives, for use internal to the AgaveTaskReply.
+ *
+ *  Only the top level of the reply is followed. Each entry of the result array is parsed alone, as soon as it is complete,
+ *  so that the whole reply is never held as one JSON document.
+ */
+
+class AgaveListingParser
+{
+public:
+    explicit AgaveListingParser();
+
+    void addData(const QByteArray &newData);
+    QList<FileMetaData> takeNewEntries();
+    //Once all data is in, gives the result of the whole listing, as a standard success/fail check would
+    RequestState getFinalState();
+    qint64 getBytesRead();
+    void reset();
+
+private:
+    void scanPendingBytes();
+    void finishString(int stringEnd);
+    void finishEntry(int entryEnd);
+
+    //Bytes not yet scanned, and those of an entry or key not yet complete
+    QByteArray pendingBytes;
+    int scanPos = 0;
+    qint64 bytesRead = 0;
+
+    int depth = 0;
+    bool inString = false;
+    bool escapeNext = false;
+    int stringStart = -1;
+    int entryStart = -1;
+
+    //Keys and values of the top level object
+    bool expectKey = false;
+    QByteArray currentKey;
+    QByteArray statusValue;
+
+    bool inResult = false;
+    bool resultSeen = false;
+    bool documentDone = false;
+    RequestState streamState = RequestState::GOOD;
+
+    QList<FileMetaData> newEntries;
+};
+
+#endif // AGAVELISTINGPARSER_H
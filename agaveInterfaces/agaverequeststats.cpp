@@ -0,0 +1,146 @@
+/*********************************************************************************
+**
+** Copyright (c) 2017 The University of Notre Dame
+** Copyright (c) 2017 The Regents of the University of California
+**
+** Redistribution and use in source and binary forms, with or without modification,
+** are permitted provided that the following conditions are met:
+**
+** 1. Redistributions of source code must retain the above copyright notice, this
+** list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright notice, this
+** list of conditions and the following disclaimer in the documentation and/or other
+** materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its contributors may
+** be used to endorse or promote products derived from this software without specific
+** prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+** EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+** SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+** TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+** BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+** CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+** IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+** SUCH DAMAGE.
+**
+***********************************************************************************/
+
+// Contributors:
+// Written by Peter Sempolinski, for the Natural Hazard Modeling Laboratory, director: Ahsan Kareem, at Notre Dame
+
+#include "agaverequeststats.h"
+
+#include <QtAlgorithms>
+#include <QMutexLocker>
+
+#include <limits>
+
+AgaveHistogram::AgaveHistogram()
+{
+    bucketCounts.fill(0, numBuckets);
+}
+
+void AgaveHistogram::addSample(qint64 newValue)
+{
+    if (newValue < 0) newValue = 0;
+
+    int bucketNum = 64 - qCountLeadingZeroBits(quint64(newValue));
+    bucketCounts[bucketNum]++;
+
+    sampleCount++;
+    sampleSum += newValue;
+    if (newValue > sampleMax) sampleMax = newValue;
+}
+
+qint64 AgaveHistogram::getCount() const
+{
+    return sampleCount;
+}
+
+qint64 AgaveHistogram::getSum() const
+{
+    return sampleSum;
+}
+
+qint64 AgaveHistogram::getMax() const
+{
+    return sampleMax;
+}
+
+qint64 AgaveHistogram::getMean() const
+{
+    if (sampleCount == 0) return 0;
+    return sampleSum / sampleCount;
+}
+
+qint64 AgaveHistogram::getPercentile(int percentile) const
+{
+    if (sampleCount == 0) return 0;
+    if (percentile < 0) percentile = 0;
+    if (percentile > 100) percentile = 100;
+
+    qint64 targetRank = (sampleCount * percentile + 99) / 100;
+    if (targetRank < 1) targetRank = 1;
+
+    qint64 samplesSoFar = 0;
+    for (int i = 0; i < numBuckets; i++)
+    {
+        samplesSoFar += bucketCounts.at(i);
+        if (samplesSoFar >= targetRank)
+        {
+            return qMin(getBucketTop(i), sampleMax);
+        }
+    }
+    return sampleMax;
+}
+
+QVector<qint64> AgaveHistogram::getBucketCounts() const
+{
+    return bucketCounts;
+}
+
+qint64 AgaveHistogram::getBucketTop(int bucketNum)
+{
+    if (bucketNum <= 0) return 0;
+    if (bucketNum >= numBuckets) bucketNum = numBuckets - 1;
+    return std::numeric_limits<qint64>::max() >> (63 - bucketNum);
+}
+
+AgaveRequestStats::AgaveRequestStats() {}
+
+void AgaveRequestStats::recordRequest(QString taskID, const AgaveRequestRecord &theRecord)
+{
+    QMutexLocker statsLocker(&statsLock);
+    AgaveTaskStats &theStats = taskStats[taskID];
+
+    if (theRecord.queueWaitMicros >= 0) theStats.queueWait.addSample(theRecord.queueWaitMicros);
+    if (theRecord.firstByteMicros >= 0) theStats.firstByte.addSample(theRecord.firstByteMicros);
+    if (theRecord.totalMicros >= 0) theStats.totalLatency.addSample(theRecord.totalMicros);
+
+    //Requests which never went out have no bytes or parse to count
+    if (theRecord.queueWaitMicros >= 0)
+    {
+        theStats.bytesIn.addSample(theRecord.bytesIn);
+        theStats.bytesOut.addSample(theRecord.bytesOut);
+        theStats.parseTime.addSample(theRecord.parseMicros);
+    }
+
+    theStats.outcomeCounts[theRecord.outcome]++;
+}
+
+QMap<QString, AgaveTaskStats> AgaveRequestStats::getTaskStats()
+{
+    QMutexLocker statsLocker(&statsLock);
+    return taskStats;
+}
+
+void AgaveRequestStats::reset()
+{
+    QMutexLocker statsLocker(&statsLock);
+    taskStats.clear();
+}
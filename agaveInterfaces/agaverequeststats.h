@@ -0,0 +1,130 @@
+/*********************************************************************************
+**
+** Copyright (c) 2017 The University of Notre Dame
+** Copyright (c) 2017 The Regents of the University of California
+**
+** Redistribution and use in source and binary forms, with or without modification,
+** are permitted provided that the following conditions are met:
+**
+** 1. Redistributions of source code must retain the above copyright notice, this
+** list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright notice, this
+** list of conditions and the following disclaimer in the documentation and/or other
+** materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its contributors may
+** be used to endorse or promote products derived from this software without specific
+** prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+** EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+** SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+** TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+** BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+** CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+** IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+** SUCH DAMAGE.
+**
+***********************************************************************************/
+
+// Contributors:
+// Written by Peter Sempolinski, for the Natural Hazard Modeling Laboratory, director: Ahsan Kareem, at Notre Dame
+
+#ifndef AGAVEREQUESTSTATS_H
+#define AGAVEREQUESTSTATS_H
+
+#include "remotedatainterface.h"
+
+#include <QMap>
+#include <QMutex>
+#include <QVector>
+
+/*! \brief The AgaveHistogram counts samples in buckets of doubling size, so that adding a sample costs only a few operations.
+ *
+ *  Bucket 0 holds zero, and bucket i holds values from 2^(i-1) up to 2^i - 1. Negative samples are counted as zero.
+ */
+
+class AgaveHistogram
+{
+public:
+    explicit AgaveHistogram();
+
+    void addSample(qint64 newValue);
+
+    qint64 getCount() const;
+    qint64 getSum() const;
+    qint64 getMax() const;
+    qint64 getMean() const;
+    //Gives the top of the bucket holding the given percentile, which is within a factor of two of the true value
+    qint64 getPercentile(int percentile) const;
+    QVector<qint64> getBucketCounts() const;
+
+    static qint64 getBucketTop(int bucketNum);
+
+private:
+    static const int numBuckets = 64;
+
+    QVector<qint64> bucketCounts;
+    qint64 sampleCount = 0;
+    qint64 sampleSum = 0;
+    qint64 sampleMax = 0;
+};
+
+/*! \brief The AgaveRequestRecord is the measure of one request, taken by its AgaveTaskReply.
+ *
+ *  Times are in microseconds, and are -1 where the request never got that far.
+ */
+
+class AgaveRequestRecord
+{
+public:
+    //From the request being asked for to its first being sent
+    qint64 queueWaitMicros = -1;
+    //From the last send to the headers of its answer
+    qint64 firstByteMicros = -1;
+    //From the request being asked for to its answer being in, with any retries
+    qint64 totalMicros = -1;
+    qint64 bytesIn = 0;
+    qint64 bytesOut = 0;
+    qint64 parseMicros = 0;
+    RequestState outcome = RequestState::GOOD;
+};
+
+/*! \brief The AgaveTaskStats are the histograms of the requests of one task.
+ */
+
+class AgaveTaskStats
+{
+public:
+    AgaveHistogram queueWait;
+    AgaveHistogram firstByte;
+    AgaveHistogram totalLatency;
+    AgaveHistogram bytesIn;
+    AgaveHistogram bytesOut;
+    AgaveHistogram parseTime;
+    QMap<RequestState, qint64> outcomeCounts;
+};
+
+/*! \brief The AgaveRequestStats collects the AgaveRequestRecord of each finished request, by task ID.
+ *
+ *  Requests are recorded on the AgaveHandler's thread, and the stats may be read or reset from any thread.
+ */
+
+class AgaveRequestStats
+{
+public:
+    explicit AgaveRequestStats();
+
+    void recordRequest(QString taskID, const AgaveRequestRecord &theRecord);
+    QMap<QString, AgaveTaskStats> getTaskStats();
+    void reset();
+
+private:
+    QMutex statsLock;
+    QMap<QString, AgaveTaskStats> taskStats;
+};
+
+#endif // AGAVEREQUESTSTATS_H
@@ -40,12 +40,16 @@
 AgaveTaskGuide::AgaveTaskGuide()
 {
     taskId = "INVALID";
+    taskType = AgaveTaskType::REGISTERED_APP;
+    priority = AgaveRequestPriority::INTERACTIVE;
 }
 
-AgaveTaskGuide::AgaveTaskGuide(QString newID, AgaveRequestType reqType)
+AgaveTaskGuide::AgaveTaskGuide(QString newID, AgaveTaskType newType, AgaveRequestType reqType)
 {
     taskId = newID;
+    taskType = newType;
     requestType = reqType;
+    priority = AgaveRequestPriority::INTERACTIVE;
 }
 
 QString AgaveTaskGuide::getTaskID()
@@ -53,15 +57,25 @@ QString AgaveTaskGuide::getTaskID()
     return taskId;
 }
 
+AgaveTaskType AgaveTaskGuide::getTaskType()
+{
+    return taskType;
+}
+
 QByteArray AgaveTaskGuide::getURLsuffix()
 {
-    return URLsuffix.toLatin1();
+    return encodedURLsuffix;
 }
 
 QByteArray AgaveTaskGuide::getArgAndURLsuffix(QMap<QString, QByteArray> * varList)
 {
-    QByteArray ret = getURLsuffix();
-    ret.append(fillURLArgList(varList));
+    QByteArray ret;
+    ret.reserve(encodedURLsuffix.size() + 128);
+    ret.append(encodedURLsuffix);
+    if (!fillTemplate(&ret, &urlFixedText, &urlArgSlots, varList, true))
+    {
+        ret.truncate(encodedURLsuffix.size());
+    }
     return ret;
 }
 
@@ -90,53 +104,190 @@ bool AgaveTaskGuide::isInternal()
     return internalTask;
 }
 
+void AgaveTaskGuide::setAsCacheable()
+{
+    cacheableTask = true;
+}
+
+bool AgaveTaskGuide::isCacheable()
+{
+    return cacheableTask;
+}
+
+void AgaveTaskGuide::setAsHedgeable()
+{
+    hedgeableTask = true;
+}
+
+bool AgaveTaskGuide::isHedgeable()
+{
+    return hedgeableTask;
+}
+
+void AgaveTaskGuide::setPriority(AgaveRequestPriority newValue)
+{
+    priority = newValue;
+}
+
+AgaveRequestPriority AgaveTaskGuide::getPriority()
+{
+    return priority;
+}
+
+void AgaveTaskGuide::setRetryPolicy(int newMaxAttempts, bool idempotent)
+{
+    maxAttempts = newMaxAttempts;
+    idempotentTask = idempotent;
+}
+
+int AgaveTaskGuide::getMaxAttempts()
+{
+    return maxAttempts;
+}
+
+bool AgaveTaskGuide::isIdempotent()
+{
+    return idempotentTask;
+}
+
+void AgaveTaskGuide::setDeadline(int newDeadline)
+{
+    deadlineMillis = qMax(0, newDeadline);
+}
+
+int AgaveTaskGuide::getDeadline()
+{
+    return deadlineMillis;
+}
+
 QByteArray AgaveTaskGuide::fillPostArgList(QMap<QString, QByteArray> *argList)
 {
-    return fillAnyArgList(argList, &postVarNames, &postFormat);
+    QByteArray ret;
+    if (!fillTemplate(&ret, &postFixedText, &postArgSlots, argList, false))
+    {
+        ret.clear();
+    }
+    return ret;
 }
 
 QByteArray AgaveTaskGuide::fillURLArgList(QMap<QString, QByteArray> *argList)
 {
-    //TODO: Check escaping of other chars
-    for (auto itr = argList->begin(); itr != argList->end(); itr++)
+    QByteArray ret;
+    if (!fillTemplate(&ret, &urlFixedText, &urlArgSlots, argList, true))
     {
-        if (!(*itr).contains('#')) continue;
-        (*itr).replace('#', "%23");
+        ret.clear();
     }
-
-    return fillAnyArgList(argList, &urlVarNames, &dynURLFormat);
+    return ret;
 }
 
-QByteArray AgaveTaskGuide::fillAnyArgList(QMap<QString, QByteArray> * argList, QList<QString> * subNames, QString * strFormat)
+void AgaveTaskGuide::compileTemplate(QString format, QList<QString> subNames, bool isPath, QList<QByteArray> * fixedText, QList<QString> * argSlots)
 {
-    QByteArray empty;
-    if (strFormat == nullptr)
+    fixedText->clear();
+    argSlots->clear();
+
+    //Fixed text is our own, so characters with meaning in a URL or post data are kept as they are
+    const QByteArray keptChars = "!$&'()*+,;=:@/?%";
+
+    QString currentText;
+    for (int i = 0; i < format.size(); i++)
     {
-        return empty;
+        int numEnd = i + 1;
+        if (format.at(i) == '%')
+        {
+            while ((numEnd < format.size()) && format.at(numEnd).isDigit()) numEnd++;
+        }
+        int argNum = format.mid(i + 1, numEnd - i - 1).toInt();
+
+        //As with QString::arg, %1 takes the first name given, %2 the second, and so on
+        if ((argNum < 1) || (argNum > subNames.size()))
+        {
+            currentText.append(format.at(i));
+            continue;
+        }
+
+        fixedText->append(currentText.toUtf8().toPercentEncoding(keptChars));
+        argSlots->append(subNames.at(argNum - 1));
+        currentText.clear();
+        i = numEnd - 1;
     }
+    fixedText->append(currentText.toUtf8().toPercentEncoding(keptChars));
 
-    if ((argList == nullptr) || (subNames == nullptr) || (subNames->empty()))
+    if (!isPath) return;
+    for (auto itr = fixedText->begin(); itr != fixedText->end(); itr++)
     {
-        return strFormat->toLatin1();
+        while ((*itr).contains("//")) (*itr).replace("//", "/");
     }
+}
 
-    QString ret = *strFormat;
-
-    for (auto itr = subNames->cbegin(); itr != subNames->cend(); ++itr)
+bool AgaveTaskGuide::fillTemplate(QByteArray * dest, QList<QByteArray> * fixedText, QList<QString> * argSlots, QMap<QString, QByteArray> * argList, bool isPath)
+{
+    for (int i = 0; i < fixedText->size(); i++)
     {
-        if (!argList->contains(*itr))
+        const QByteArray &nextText = fixedText->at(i);
+        if (isPath && nextText.startsWith('/') && dest->endsWith('/'))
+        {
+            dest->append(nextText.constData() + 1, nextText.size() - 1);
+        }
+        else
         {
-            return empty;
+            dest->append(nextText);
         }
 
-        ret = ret.arg(QString::fromLatin1(argList->value(*itr)));
+        if (i >= argSlots->size()) break;
+
+        if ((argList == nullptr) || !argList->contains(argSlots->at(i)))
+        {
+            return false;
+        }
+        appendEncoded(dest, argList->value(argSlots->at(i)), isPath);
+    }
+    return true;
+}
+
+void AgaveTaskGuide::appendEncoded(QByteArray * dest, const QByteArray &rawValue, bool isPath)
+{
+    //Args are UTF-8, and only unreserved characters and slashes pass unencoded
+    //In a path, runs of slashes are collapsed to one
+    static const char hexDigits[] = "0123456789ABCDEF";
+
+    for (char oneChar : rawValue)
+    {
+        uchar byteVal = static_cast<uchar>(oneChar);
+        if (((byteVal >= 'a') && (byteVal <= 'z')) || ((byteVal >= 'A') && (byteVal <= 'Z')) ||
+                ((byteVal >= '0') && (byteVal <= '9')) ||
+                (byteVal == '-') || (byteVal == '.') || (byteVal == '_') || (byteVal == '~'))
+        {
+            dest->append(oneChar);
+        }
+        else if (byteVal == '/')
+        {
+            if (isPath && dest->endsWith('/')) continue;
+            dest->append(oneChar);
+        }
+        else
+        {
+            dest->append('%');
+            dest->append(hexDigits[byteVal >> 4]);
+            dest->append(hexDigits[byteVal & 0xF]);
+        }
     }
-    return ret.toLatin1();
+}
+
+void AgaveTaskGuide::compileURLTemplate()
+{
+    //The suffix and the dynamic part are compiled together, so a slash between them is not doubled
+    QList<QByteArray> suffixText;
+    QList<QString> noSlots;
+    compileTemplate(URLsuffix, QList<QString>(), true, &suffixText, &noSlots);
+    encodedURLsuffix = suffixText.first();
+
+    compileTemplate(dynURLFormat, urlVarNames, true, &urlFixedText, &urlArgSlots);
 }
 
 void AgaveTaskGuide::setURLsuffix(QString newValue)
 {
     URLsuffix = newValue;
+    compileURLTemplate();
 }
 
 void AgaveTaskGuide::setHeaderType(AuthHeaderType newValue)
@@ -159,6 +310,7 @@ void AgaveTaskGuide::setDynamicURLParams(QString format, QList<QString> subNames
 {
     dynURLFormat = format;
     urlVarNames = subNames;
+    compileURLTemplate();
 }
 
 void AgaveTaskGuide::setPostParams(QString format)
@@ -171,6 +323,7 @@ void AgaveTaskGuide::setPostParams(QString format, QList<QString> subNames)
 {
     postFormat = format;
     postVarNames = subNames;
+    compileTemplate(postFormat, postVarNames, false, &postFixedText, &postArgSlots);
 }
 
 bool AgaveTaskGuide::usesPostParms()
@@ -39,6 +39,8 @@
 #include <QStringList>
 
 enum class AgaveRequestType;
+enum class AgaveRequestPriority;
+enum class AgaveTaskType;
 
 enum class AuthHeaderType {NONE, PASSWD, CLIENT, TOKEN, REFRESH};
 
@@ -47,7 +49,7 @@ class AgaveTaskGuide
 {
 public:
     explicit AgaveTaskGuide();
-    explicit AgaveTaskGuide(QString newID, AgaveRequestType reqType);
+    explicit AgaveTaskGuide(QString newID, AgaveTaskType newType, AgaveRequestType reqType);
 
     void setURLsuffix(QString newValue);
     void setHeaderType(AuthHeaderType newValue);
@@ -58,6 +60,11 @@ public:
     void setPostParams(QString format);
     void setPostParams(QString format, QList<QString> subNames);
     void setAsInternal();
+    void setAsCacheable();
+    void setAsHedgeable();
+    void setPriority(AgaveRequestPriority newValue);
+    void setRetryPolicy(int maxAttempts, bool idempotent);
+    void setDeadline(int deadlineMillis);
 
     void setAgaveFullName(QString newFullName);
     void setAgavePWDparam(QString newPWDparam);
@@ -65,6 +72,7 @@ public:
     void setAgaveInputList(QStringList newInputList);
 
     QString getTaskID();
+    AgaveTaskType getTaskType();
     QByteArray getURLsuffix();
     QByteArray getArgAndURLsuffix(QMap<QString, QByteArray> * varList = nullptr);
     AgaveRequestType getRequestType();
@@ -73,6 +81,12 @@ public:
     QByteArray fillURLArgList(QMap<QString, QByteArray> * argList = nullptr);
     bool isTokenFormat();
     bool isInternal();
+    bool isCacheable();
+    bool isHedgeable();
+    AgaveRequestPriority getPriority();
+    int getMaxAttempts();
+    bool isIdempotent();
+    int getDeadline();
 
     QString getAgaveFullName();
     QString getAgavePWDparam();
@@ -84,21 +98,45 @@ public:
 
 private:
     QString taskId;
+    AgaveTaskType taskType;
 
     QString URLsuffix = "";
     AgaveRequestType requestType;
     AuthHeaderType headerType = AuthHeaderType::NONE;
+    AgaveRequestPriority priority;
 
-    QByteArray fillAnyArgList(QMap<QString, QByteArray> * argList, QList<QString> * subNames, QString * strFormat);
+    //Formats are split once, when set, into fixed text, already encoded, and the names of the args between,
+    //so that filling them in is a single pass of appends, with each arg percent-encoded as it goes
+    static void compileTemplate(QString format, QList<QString> subNames, bool isPath, QList<QByteArray> * fixedText, QList<QString> * argSlots);
+    static bool fillTemplate(QByteArray * dest, QList<QByteArray> * fixedText, QList<QString> * argSlots, QMap<QString, QByteArray> * argList, bool isPath);
+    static void appendEncoded(QByteArray * dest, const QByteArray &rawValue, bool isPath);
+    void compileURLTemplate();
 
     bool internalTask = false;
+    bool cacheableTask = false;
+    //Only reads, which are safe to send twice, should be hedged
+    bool hedgeableTask = false;
     bool usesTokenFormat = false;
 
+    //Tasks are sent once unless given a retry policy. Only idempotent tasks are sent again
+    //after a failure which the server may have seen, the rest only if the server refused them.
+    int maxAttempts = 1;
+    bool idempotentTask = false;
+
+    //Each try of the task is stopped if it is not done in this time. Zero means it may take as long as it needs.
+    int deadlineMillis = 0;
+
     QString postFormat = "";
     QString dynURLFormat = "";
     QStringList postVarNames;
     QStringList urlVarNames;
 
+    QByteArray encodedURLsuffix;
+    QList<QByteArray> urlFixedText;
+    QList<QString> urlArgSlots;
+    QList<QByteArray> postFixedText;
+    QList<QString> postArgSlots;
+
     QString agaveFullName;
     QString agavePWDparam;
     QStringList agaveParamList;
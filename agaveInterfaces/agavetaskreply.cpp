@@ -41,6 +41,8 @@
 #include "filemetadata.h"
 #include "remotejobdata.h"
 
+#include <QtConcurrent>
+
 AgaveTaskReply::AgaveTaskReply(AgaveTaskGuide * theGuide, QNetworkReply * newReply, AgaveHandler *theManager, QObject *parent) : RemoteDataReply(parent)
 {
     if (!performInitPointerCheck(theGuide, theManager)) return;
@@ -61,7 +63,7 @@ AgaveTaskReply::AgaveTaskReply(AgaveTaskGuide * theGuide, QNetworkReply * newRep
 
     if (myReplyObject != nullptr)
     {
-        QObject::connect(myReplyObject, SIGNAL(finished()), this, SLOT(rawHttpTaskComplete()));
+        attachNetworkReply(myReplyObject);
     }
     else
     {
@@ -70,12 +72,32 @@ AgaveTaskReply::AgaveTaskReply(AgaveTaskGuide * theGuide, QNetworkReply * newRep
     }
 }
 
+AgaveTaskReply::AgaveTaskReply(AgaveTaskGuide * theGuide, QMap<QString, QByteArray> taskVars, AgaveHandler * theManager, QObject *parent) : RemoteDataReply(parent)
+{
+    //The http request for this reply is sent later, when the manager's scheduler has room for it
+    if (!performInitPointerCheck(theGuide, theManager)) return;
+    taskParamList = taskVars;
+
+    //Data to upload is held apart from the request's parameters, which are copied freely
+    if (myGuide->getRequestType() == AgaveRequestType::AGAVE_PIPE_UPLOAD)
+    {
+        uploadData = taskParamList.take("fileData");
+    }
+}
+
 AgaveTaskReply::AgaveTaskReply(AgaveTaskGuide * theGuide, RequestState passThruErrorState, AgaveHandler * theManager, QObject *parent) : RemoteDataReply(parent)
 {
     if (!performInitPointerCheck(theGuide, theManager)) return;
     setDelayedDatalessReply(passThruErrorState);
 }
 
+AgaveTaskReply::AgaveTaskReply(AgaveHandler * theManager, QObject *parent) : RemoteDataReply(parent)
+{
+    //For a request submitted from another thread, this reply is given back at once, and a second one,
+    //beside it on the same thread, relays the results of the request, once the manager has made it
+    myManager = theManager;
+}
+
 bool AgaveTaskReply::performInitPointerCheck(AgaveTaskGuide * theGuide, AgaveHandler * theManager)
 {
     myManager = theManager;
@@ -92,127 +114,536 @@ bool AgaveTaskReply::performInitPointerCheck(AgaveTaskGuide * theGuide, AgaveHan
         setDelayedDatalessReply(RequestState::UNKNOWN_TASK);
         return false;
     }
+
+    statsSink = myManager->requestStats;
+    requestClock.start();
     return true;
 }
 
 AgaveTaskReply::~AgaveTaskReply()
 {
+    //Once the manager is gone, so are its stats, and nothing is recorded
+    QSharedPointer<AgaveRequestStats> theStats = statsSink.toStrongRef();
+    if (requestFinished && !theStats.isNull())
+    {
+        theStats->recordRequest(myGuide->getTaskID(), statsRecord);
+    }
+
+    //A reply given back to another thread lets go of its request, which stops unless another reply follows it
+    if (!handleLink.isNull())
+    {
+        QMutexLocker linkLocker(&handleLink->linkLock);
+        if (!handleLink->released) releaseLinkedRequest();
+        handleLink->released = true;
+        handleLink->handle = nullptr;
+        handleLink->relay = nullptr;
+        delete handleRelay;
+        handleRelay = nullptr;
+    }
+    if (handleGuide != nullptr)
+    {
+        delete handleGuide;
+    }
+
+    dropHedge();
+
+    if (validatedEntry != nullptr)
+    {
+        delete validatedEntry;
+    }
+
     if (myReplyObject != nullptr)
     {
         myReplyObject->deleteLater();
     }
+
+    //A download never committed leaves its partial file, which is kept only if it can be resumed
+    //Segments share their file with the other segments, and the parent download cleans it up
+    if ((myGuide != nullptr) && (myGuide->getRequestType() == AgaveRequestType::AGAVE_DOWNLOAD) &&
+            taskParamList.contains("localDest") && !isDownloadSegment() && !downloadCommitted)
+    {
+        if (keepPartialDownload)
+        {
+            writeDownloadRecord();
+            if (downloadHandle != nullptr) downloadHandle->close();
+        }
+        else
+        {
+            discardPartialDownload();
+        }
+    }
 }
 
-QMap<QString, QByteArray> * AgaveTaskReply::getTaskParamList()
+void AgaveTaskReply::attachNetworkReply(QNetworkReply * newReply)
 {
-    return &taskParamList;
+    myReplyObject = newReply;
+
+    QObject::connect(myReplyObject, SIGNAL(finished()), this, SLOT(rawHttpTaskComplete()));
+
+    //Each try has the task's own deadline, unless the user gave one for the whole request
+    if (!explicitDeadline && (myGuide->getDeadline() > 0))
+    {
+        startDeadline(myGuide->getDeadline());
+    }
+
+    sendClock.start();
+    if (statsRecord.queueWaitMicros < 0)
+    {
+        statsRecord.queueWaitMicros = requestClock.nsecsElapsed() / 1000;
+    }
+    statsRecord.firstByteMicros = -1;
+    QObject::connect(myReplyObject, SIGNAL(metaDataChanged()), this, SLOT(rawFirstByte()));
+    QObject::connect(myReplyObject, SIGNAL(downloadProgress(qint64,qint64)), this, SLOT(rawDownloadProgress(qint64,qint64)));
+    QObject::connect(myReplyObject, SIGNAL(uploadProgress(qint64,qint64)), this, SLOT(rawUploadProgress(qint64,qint64)));
+
+    int hedgeDelay = myManager->getHedgeDelay(myGuide);
+    if (hedgeDelay >= 0)
+    {
+        if (hedgeTimer == nullptr)
+        {
+            hedgeTimer = new QTimer(this);
+            hedgeTimer->setSingleShot(true);
+            QObject::connect(hedgeTimer, SIGNAL(timeout()), this, SLOT(sendHedge()));
+        }
+        hedgeTimer->start(hedgeDelay);
+    }
+    if ((myGuide->getRequestType() == AgaveRequestType::AGAVE_DOWNLOAD) ||
+            (myGuide->getRequestType() == AgaveRequestType::AGAVE_PIPE_DOWNLOAD))
+    {
+        QObject::connect(myReplyObject, SIGNAL(readyRead()), this, SLOT(rawDownloadDataReady()));
+    }
+    else if (isStreamedListing())
+    {
+        QObject::connect(myReplyObject, SIGNAL(readyRead()), this, SLOT(rawListingDataReady()));
+    }
 }
 
-void AgaveTaskReply::setAsUnconnectedReply()
+void AgaveTaskReply::forwardSignalsFrom(AgaveTaskReply * sourceReply, Qt::ConnectionType connectionType)
 {
-    expectsSignalConnect = false;
+    QObject::connect(sourceReply, SIGNAL(startedLogout(RequestState)),
+                     this, SIGNAL(startedLogout(RequestState)), connectionType);
+    QObject::connect(sourceReply, SIGNAL(haveAuthReply(RequestState)),
+                     this, SIGNAL(haveAuthReply(RequestState)), connectionType);
+    QObject::connect(sourceReply, SIGNAL(haveLSReply(RequestState,QList<FileMetaData>)),
+                     this, SIGNAL(haveLSReply(RequestState,QList<FileMetaData>)), connectionType);
+    QObject::connect(sourceReply, SIGNAL(haveLSPartialReply(RequestState,QList<FileMetaData>)),
+                     this, SIGNAL(haveLSPartialReply(RequestState,QList<FileMetaData>)), connectionType);
+    QObject::connect(sourceReply, SIGNAL(haveDeleteReply(RequestState,QString)),
+                     this, SIGNAL(haveDeleteReply(RequestState,QString)), connectionType);
+    QObject::connect(sourceReply, SIGNAL(haveMoveReply(RequestState,FileMetaData,QString)),
+                     this, SIGNAL(haveMoveReply(RequestState,FileMetaData,QString)), connectionType);
+    QObject::connect(sourceReply, SIGNAL(haveCopyReply(RequestState,FileMetaData)),
+                     this, SIGNAL(haveCopyReply(RequestState,FileMetaData)), connectionType);
+    QObject::connect(sourceReply, SIGNAL(haveRenameReply(RequestState,FileMetaData,QString)),
+                     this, SIGNAL(haveRenameReply(RequestState,FileMetaData,QString)), connectionType);
+    QObject::connect(sourceReply, SIGNAL(haveBatchProgress(int,int,int)),
+                     this, SIGNAL(haveBatchProgress(int,int,int)), connectionType);
+    QObject::connect(sourceReply, SIGNAL(haveBatchReply(RequestState,QList<RemoteFileOpResult>)),
+                     this, SIGNAL(haveBatchReply(RequestState,QList<RemoteFileOpResult>)), connectionType);
+    QObject::connect(sourceReply, SIGNAL(haveMkdirReply(RequestState,FileMetaData)),
+                     this, SIGNAL(haveMkdirReply(RequestState,FileMetaData)), connectionType);
+    QObject::connect(sourceReply, SIGNAL(haveUploadReply(RequestState,FileMetaData)),
+                     this, SIGNAL(haveUploadReply(RequestState,FileMetaData)), connectionType);
+    QObject::connect(sourceReply, SIGNAL(haveDownloadReply(RequestState,QString)),
+                     this, SIGNAL(haveDownloadReply(RequestState,QString)), connectionType);
+    QObject::connect(sourceReply, SIGNAL(haveBufferDownloadReply(RequestState,QByteArray)),
+                     this, SIGNAL(haveBufferDownloadReply(RequestState,QByteArray)), connectionType);
+    QObject::connect(sourceReply, SIGNAL(haveStoppedJob(RequestState)),
+                     this, SIGNAL(haveStoppedJob(RequestState)), connectionType);
+    QObject::connect(sourceReply, SIGNAL(haveDeletedJob(RequestState)),
+                     this, SIGNAL(haveDeletedJob(RequestState)), connectionType);
+    QObject::connect(sourceReply, SIGNAL(haveJobList(RequestState,QList<RemoteJobData>)),
+                     this, SIGNAL(haveJobList(RequestState,QList<RemoteJobData>)), connectionType);
+    QObject::connect(sourceReply, SIGNAL(haveJobDetails(RequestState,RemoteJobData)),
+                     this, SIGNAL(haveJobDetails(RequestState,RemoteJobData)), connectionType);
+    QObject::connect(sourceReply, SIGNAL(haveJobReply(RequestState,QJsonDocument)),
+                     this, SIGNAL(haveJobReply(RequestState,QJsonDocument)), connectionType);
+    QObject::connect(sourceReply, SIGNAL(haveAgaveAppList(RequestState,QVariantList)),
+                     this, SIGNAL(haveAgaveAppList(RequestState,QVariantList)), connectionType);
 }
 
-void AgaveTaskReply::setDelayedDatalessReply(RequestState replyState)
+void AgaveTaskReply::followReply(AgaveTaskReply * leaderReply)
 {
-    pendingReply = replyState;
+    //A follower sends no request of its own, and passes on whatever the leader reply gets
+    forwardSignalsFrom(leaderReply, Qt::AutoConnection);
 
-    QTimer * quickTimer = new QTimer(qobject_cast<QObject*>(this));
-    QObject::connect(quickTimer, SIGNAL(timeout()), this, SLOT(rawPassThruTaskComplete()));
-    quickTimer->start(1);
+    QObject::connect(leaderReply, SIGNAL(destroyed()), this, SLOT(deleteLater()));
+
+    followedReply = leaderReply;
+    //A follower sends nothing of its own, so only the leader is recorded in the stats
+    statsSink.clear();
+    if (myGuide == nullptr) myGuide = leaderReply->myGuide;
 }
 
-AgaveTaskGuide * AgaveTaskReply::getTaskGuide()
+void AgaveTaskReply::releaseLinkedRequest()
 {
-    return myGuide;
-}
+    //Called on the caller's thread, with the link locked. The request, on the manager's thread,
+    //stops relaying to this reply, and is stopped if nothing else follows it.
+    if (!handleLink->requestMade || handleLink->requestDone) return;
 
-void AgaveTaskReply::processDatalessReply(RequestState replyState)
-{   
-    if (replyState != RequestState::GOOD)
+    QSharedPointer<AgaveHandleLink> theLink = handleLink;
+    QMetaObject::invokeMethod(handleLink->madeReply, [theLink]()
     {
-        qCDebug(remoteInterface, "Agave Task Fail: %s", qPrintable(RemoteDataInterface::interpretRequestState(replyState)));
-    }
+        QMutexLocker linkLocker(&theLink->linkLock);
+        if (theLink->requestDone) return;
+        AgaveTaskReply * madeReply = theLink->madeReply;
+        if (theLink->relay != nullptr)
+        {
+            QObject::disconnect(madeReply, nullptr, theLink->relay, nullptr);
+        }
+        linkLocker.unlock();
+        madeReply->stopIfUnwatched();
+    }, Qt::QueuedConnection);
+}
+
+bool AgaveTaskReply::canTakeFollowers()
+{
+    if (stopState != RequestState::GOOD) return false;
+
+    //Once the leader has its result, a new follower would never hear anything
+    if (hasPendingReply) return false;
+    //Nor would it hear the batches of a listing already given out
+    if (listingBatchStart > 0) return false;
+    if (myReplyObject == nullptr) return true;
+    return !myReplyObject->isFinished();
+}
+
+QMap<QString, QByteArray> * AgaveTaskReply::getTaskParamList()
+{
+    return &taskParamList;
+}
+
+void AgaveTaskReply::setAsUnconnectedReply()
+{
+    expectsSignalConnect = false;
+}
 
-    if (myGuide->getTaskID() == "fullAuth")
+void AgaveTaskReply::cancel()
+{
+    if (QThread::currentThread() != this->thread())
     {
-        emit haveAuthReply(replyState);
+        QMetaObject::invokeMethod(this, "cancel", Qt::QueuedConnection);
+        return;
     }
-    else if (myGuide->getTaskID() == "authRefresh")
+
+    stopRequest(RequestState::STOPPED_BY_USER);
+}
+
+void AgaveTaskReply::setDeadline(int deadlineMillis)
+{
+    if (QThread::currentThread() != this->thread())
     {
-        //TODO: Auth refresh needs to be implemented
-        qCDebug(remoteInterface, "Auth refresh fail: Not yet implemented");
+        QMetaObject::invokeMethod(this, "setDeadline", Qt::QueuedConnection,
+                                  Q_ARG(int, deadlineMillis));
         return;
     }
-    else if (myGuide->getTaskID() == "dirListing")
+
+    explicitDeadline = (deadlineMillis > 0);
+    if (explicitDeadline)
     {
-        emit haveLSReply(replyState, QList<FileMetaData>());
+        startDeadline(deadlineMillis);
     }
-    else if (myGuide->getTaskID() == "startedLogout")
+    else if (deadlineTimer != nullptr)
     {
-        emit startedLogout(replyState);
+        deadlineTimer->stop();
     }
-    else if ((myGuide->getTaskID() == "fileUpload") || (myGuide->getTaskID() == "filePipeUpload"))
+}
+
+void AgaveTaskReply::startDeadline(int deadlineMillis)
+{
+    if (deadlineTimer == nullptr)
     {
-        emit haveUploadReply(replyState, FileMetaData());
+        deadlineTimer = new QTimer(this);
+        deadlineTimer->setSingleShot(true);
+        QObject::connect(deadlineTimer, SIGNAL(timeout()), this, SLOT(deadlinePassed()));
     }
-    else if (myGuide->getTaskID() == "fileDelete")
+    deadlineTimer->start(deadlineMillis);
+}
+
+void AgaveTaskReply::deadlinePassed()
+{
+    qCDebug(remoteInterface, "Request ran out of time: %s", (myGuide != nullptr) ? qPrintable(myGuide->getTaskID()) : "submitted");
+    stopRequest(RequestState::REQUEST_TIMEOUT);
+}
+
+void AgaveTaskReply::stopRequest(RequestState newStopState)
+{
+    if (requestFinished || (stopState != RequestState::GOOD)) return;
+    if (!followedReply.isNull() && followedReply->requestFinished) return;
+
+    if (!handleLink.isNull())
     {
-        emit haveDeleteReply(replyState, QString());
+        //A reply given back to another thread gives nothing more from its relay, unless the request is already done
+        QMutexLocker linkLocker(&handleLink->linkLock);
+        if (handleLink->requestDone) return;
+
+        stopState = newStopState;
+        if (deadlineTimer != nullptr) deadlineTimer->stop();
+        QObject::disconnect(handleRelay, nullptr, this, nullptr);
+        releaseLinkedRequest();
+        handleLink->released = true;
+
+        //Until the request is made, the manager's thread finishes the stop, once it knows the task
+        if (handleLink->requestMade)
+        {
+            QTimer::singleShot(0, this, SLOT(finishStoppedRequest()));
+        }
+        return;
     }
-    else if (myGuide->getTaskID() == "newFolder")
+
+    stopState = newStopState;
+    if (deadlineTimer != nullptr) deadlineTimer->stop();
+
+    //A follower stops listening, and the request it follows is stopped only if no one else still wants it
+    if (!followedReply.isNull())
     {
-        emit haveMkdirReply(replyState, FileMetaData());
+        QObject::disconnect(followedReply.data(), nullptr, this, nullptr);
+        followedReply->stopIfUnwatched();
+        QTimer::singleShot(0, this, SLOT(finishStoppedRequest()));
+        return;
     }
-    else if (myGuide->getTaskID() == "renameFile")
+
+    //The parts of a larger task are stopped with it, and those not yet sent are refused
+    subtaskState = newStopState;
+    for (AgaveTaskReply * aSubtask : findChildren<AgaveTaskReply *>(QString(), Qt::FindDirectChildrenOnly))
     {
-        emit haveRenameReply(replyState, FileMetaData(), QString());
+        aSubtask->stopRequest(newStopState);
     }
-    else if (myGuide->getTaskID() == "fileMove")
+
+    //Aborting a request on the network frees its place at once, and its finish gives the stopped state
+    dropHedge();
+    if ((myReplyObject != nullptr) && myReplyObject->isRunning())
     {
-        emit haveMoveReply(replyState, FileMetaData(), QString());
+        myReplyObject->abort();
+        return;
     }
-    else if (myGuide->getTaskID() == "fileCopy")
+
+    //Otherwise, the request is waiting to be sent, to be retried, or for a new token, or is made of other requests
+    QTimer::singleShot(0, this, SLOT(finishStoppedRequest()));
+}
+
+void AgaveTaskReply::sendHedge()
+{
+    if ((stopState != RequestState::GOOD) || (hedgeReplyObject != nullptr)) return;
+    if ((myReplyObject == nullptr) || !myReplyObject->isRunning()) return;
+
+    //Hedging is for a server slow to answer. Once the answer has started, it is left to finish.
+    if (myReplyObject->attribute(QNetworkRequest::HttpStatusCodeAttribute).isValid()) return;
+
+    hedgeReplyObject = myManager->sendHedgeRequest(this);
+    if (hedgeReplyObject == nullptr) return;
+
+    hedgeClock.start();
+    QObject::connect(hedgeReplyObject, SIGNAL(finished()), this, SLOT(hedgeFinished()));
+}
+
+void AgaveTaskReply::hedgeFinished()
+{
+    QNetworkReply * finishedHedge = hedgeReplyObject;
+    if ((finishedHedge == nullptr) || (sender() != finishedHedge)) return;
+    hedgeReplyObject = nullptr;
+
+    //A failed hedge is let go, and the first request carries on. So is a hedge for a listing already partly given out.
+    if ((finishedHedge->error() != QNetworkReply::NoError) || (listingBatchStart > 0))
     {
-        emit haveCopyReply(replyState,FileMetaData());
+        finishedHedge->deleteLater();
+        return;
     }
-    else if (myGuide->getTaskID() == "fileDownload")
+
+    qCDebug(remoteInterface, "Hedge answered first: %s", qPrintable(myGuide->getTaskID()));
+
+    //The first request is aborted, and this reply goes on as though the hedge had been its request all along
+    QNetworkReply * slowReply = myReplyObject;
+    QObject::disconnect(slowReply, nullptr, this, nullptr);
+    slowReply->abort();
+    slowReply->deleteLater();
+
+    listingParser.reset();
+    listingSoFar.clear();
+    myReplyObject = finishedHedge;
+    sendClock = hedgeClock;
+    statsRecord.bytesIn = finishedHedge->bytesAvailable();
+    rawHttpTaskComplete();
+}
+
+void AgaveTaskReply::dropHedge()
+{
+    if (hedgeTimer != nullptr) hedgeTimer->stop();
+    if (hedgeReplyObject == nullptr) return;
+
+    QNetworkReply * unneededHedge = hedgeReplyObject;
+    hedgeReplyObject = nullptr;
+    QObject::disconnect(unneededHedge, nullptr, this, nullptr);
+    unneededHedge->abort();
+    unneededHedge->deleteLater();
+}
+
+void AgaveTaskReply::rawFirstByte()
+{
+    if (statsRecord.firstByteMicros >= 0) return;
+    statsRecord.firstByteMicros = sendClock.nsecsElapsed() / 1000;
+}
+
+void AgaveTaskReply::rawDownloadProgress(qint64 bytesReceived, qint64)
+{
+    statsRecord.bytesIn = bytesReceived;
+}
+
+void AgaveTaskReply::rawUploadProgress(qint64 bytesSent, qint64)
+{
+    statsRecord.bytesOut = bytesSent;
+}
+
+void AgaveTaskReply::markRequestFinished()
+{
+    requestFinished = true;
+    statsRecord.totalMicros = requestClock.nsecsElapsed() / 1000;
+    uploadData.clear();
+}
+
+void AgaveTaskReply::stopIfUnwatched()
+{
+    if (anySignalConnect()) return;
+    stopRequest(RequestState::STOPPED_BY_USER);
+}
+
+void AgaveTaskReply::finishStoppedRequest()
+{
+    if (requestFinished) return;
+    markRequestFinished();
+    statsRecord.outcome = stopState;
+    this->deleteLater();
+
+    //A reply given back to another thread takes its task from its own copy of the request's guide
+    if (!handleLink.isNull() && (myGuide == nullptr))
     {
-        emit haveDownloadReply(replyState, QString());
+        QMutexLocker linkLocker(&handleLink->linkLock);
+        if (handleLink->madeGuide == nullptr) return;
+        handleGuide = new AgaveTaskGuide(*handleLink->madeGuide);
+        myGuide = handleGuide;
     }
-    else if (myGuide->getTaskID() == "filePipeDownload")
+
+    //As with a lost connection, a download which runs out of time may be resumed later
+    if ((stopState == RequestState::REQUEST_TIMEOUT) && (myReplyObject != nullptr))
     {
-        emit haveBufferDownloadReply(replyState, nullptr);
+        retainPartialDownload();
     }
-    else if (myGuide->getTaskID() == "getJobList")
+
+    if (myGuide->isInternal())
     {
-        emit haveJobList(replyState, QList<RemoteJobData>());
+        myManager->handleInternalTask(this, stopState);
+        return;
     }
-    else if (myGuide->getTaskID() == "getJobDetails")
+    processDatalessReply(stopState);
+}
+
+void AgaveTaskReply::setDelayedDatalessReply(RequestState replyState)
+{
+    pendingReply = replyState;
+
+    QTimer * quickTimer = new QTimer(qobject_cast<QObject*>(this));
+    QObject::connect(quickTimer, SIGNAL(timeout()), this, SLOT(rawPassThruTaskComplete()));
+    quickTimer->start(1);
+}
+
+AgaveTaskGuide * AgaveTaskReply::getTaskGuide()
+{
+    return myGuide;
+}
+
+void AgaveTaskReply::processDatalessReply(RequestState replyState)
+{   
+    statsRecord.outcome = replyState;
+    if (replyState != RequestState::GOOD)
     {
-        emit haveJobDetails(replyState, RemoteJobData::nil());
+        qCDebug(remoteInterface, "Agave Task Fail: %s", qPrintable(RemoteDataInterface::interpretRequestState(replyState)));
     }
-    else if (myGuide->getTaskID() == "stopJob")
+
+    //Most tasks emit a signal of their own, with their own empty arguments. A table of member function
+    //pointers would need a small method for each of them, so a switch, which compiles to a jump table, is kept.
+    switch (myGuide->getTaskType())
     {
+    case AgaveTaskType::FULL_AUTH:
+        emit haveAuthReply(replyState);
+        break;
+    case AgaveTaskType::AUTH_REFRESH:
+        //Token refresh results only go to the AgaveHandler
+        return;
+    case AgaveTaskType::DIR_LISTING:
+    case AgaveTaskType::DIR_LISTING_BATCHES:
+        emit haveLSReply(replyState, QList<FileMetaData>());
+        break;
+    case AgaveTaskType::DIR_PAGED_LISTING:
+        //The pages, given out in order, make up the whole listing
+        emit haveLSReply(replyState, (replyState == RequestState::GOOD) ? listingSoFar : QList<FileMetaData>());
+        break;
+    case AgaveTaskType::STARTED_LOGOUT:
+        emit startedLogout(replyState);
+        break;
+    case AgaveTaskType::FILE_UPLOAD:
+    case AgaveTaskType::FILE_PIPE_UPLOAD:
+        emit haveUploadReply(replyState, FileMetaData());
+        break;
+    case AgaveTaskType::FILE_CHUNKED_UPLOAD:
+        //The final part of the upload fills in the new file's data
+        emit haveUploadReply(replyState, subtaskFileResult);
+        break;
+    case AgaveTaskType::FILE_DELETE:
+        emit haveDeleteReply(replyState, QString());
+        break;
+    case AgaveTaskType::NEW_FOLDER:
+        emit haveMkdirReply(replyState, FileMetaData());
+        break;
+    case AgaveTaskType::RENAME_FILE:
+        emit haveRenameReply(replyState, FileMetaData(), QString());
+        break;
+    case AgaveTaskType::FILE_MOVE:
+        emit haveMoveReply(replyState, FileMetaData(), QString());
+        break;
+    case AgaveTaskType::FILE_COPY:
+        emit haveCopyReply(replyState,FileMetaData());
+        break;
+    case AgaveTaskType::FILE_BATCH:
+        emit haveBatchReply(replyState, batchResults);
+        break;
+    case AgaveTaskType::FILE_DOWNLOAD:
+    case AgaveTaskType::FILE_SEGMENTED_DOWNLOAD:
+        emit haveDownloadReply(replyState, taskParamList.value("localDest"));
+        break;
+    case AgaveTaskType::FILE_PIPE_DOWNLOAD:
+        emit haveBufferDownloadReply(replyState, nullptr);
+        break;
+    case AgaveTaskType::GET_JOB_LIST:
+    case AgaveTaskType::GET_JOB_CHANGES:
+        //The pages, put together, make up the whole list
+        emit haveJobList(replyState, (replyState == RequestState::GOOD) ? jobListSoFar : QList<RemoteJobData>());
+        break;
+    case AgaveTaskType::GET_JOB_DETAILS:
+        emit haveJobDetails(replyState, RemoteJobData::nil());
+        break;
+    case AgaveTaskType::STOP_JOB:
         emit haveStoppedJob(replyState);
-    }
-    else if (myGuide->getTaskID() == "deleteJob")
-    {
+        break;
+    case AgaveTaskType::DELETE_JOB:
         emit haveDeletedJob(replyState);
-    }
-    else if (myGuide->getTaskID() == "haveAgaveAppList")
-    {
+        break;
+    case AgaveTaskType::GET_AGAVE_LIST:
         emit haveAgaveAppList(replyState, QVariantList());
-    }
-    else
-    {
+        break;
+    default:
         emit haveJobReply(replyState, QJsonDocument());
+        break;
     }
 
 }
 
 void AgaveTaskReply::rawNoDataNoHttpTaskComplete(RequestState replyState)
 {
+    if (stopState != RequestState::GOOD)
+    {
+        finishStoppedRequest();
+        return;
+    }
     this->deleteLater();
 
     if (myGuide->getRequestType() != AgaveRequestType::AGAVE_NONE)
@@ -227,6 +658,13 @@ void AgaveTaskReply::rawNoDataNoHttpTaskComplete(RequestState replyState)
 
 void AgaveTaskReply::rawPassThruTaskComplete()
 {
+    if (stopState != RequestState::GOOD)
+    {
+        finishStoppedRequest();
+        return;
+    }
+    markRequestFinished();
+    statsRecord.outcome = pendingReply;
     this->deleteLater();
 
     //If this task is an INTERNAL task, then the result is redirected to the manager
@@ -242,11 +680,62 @@ void AgaveTaskReply::rawPassThruTaskComplete()
 
 void AgaveTaskReply::rawHttpTaskComplete()
 {
+    if (myReplyObject != nullptr)
+    {
+        myManager->noteTlsSession(myReplyObject);
+    }
+
+    //The first answer wins, so a hedge still out is no longer needed
+    dropHedge();
+
+    //A stopped request is not retried, and gives the state it was stopped with
+    if (stopState != RequestState::GOOD)
+    {
+        finishStoppedRequest();
+        return;
+    }
+    if ((deadlineTimer != nullptr) && !explicitDeadline)
+    {
+        deadlineTimer->stop();
+    }
+    if ((myReplyObject != nullptr) && (myReplyObject->error() == QNetworkReply::NoError))
+    {
+        myManager->noteRequestLatency(myGuide, sendClock.elapsed());
+    }
+
+    if (isExpiredTokenReply())
+    {
+        myManager->holdForTokenRefresh(this);
+        return;
+    }
+
+    if (isRetryableFailure() && myManager->scheduleRetry(this))
+    {
+        return;
+    }
+
+    markRequestFinished();
+    if (offloadJobListParse()) return;
     this->deleteLater();
 
     //If this task is an INTERNAL task, then the result is redirected to the manager
     if (myGuide->isInternal())
     {
+        if (isDownloadSegment())
+        {
+            statsRecord.outcome = finishDownloadSegment();
+            myManager->handleDownloadSegment(this, statsRecord.outcome);
+            return;
+        }
+        if (isJobListPage())
+        {
+            readJobListPage();
+            return;
+        }
+        if ((myReplyObject != nullptr) && (myReplyObject->error() != QNetworkReply::NoError))
+        {
+            statsRecord.outcome = interpretNetworkError(myReplyObject);
+        }
         myManager->handleInternalTask(this, myReplyObject);
         return;
     }
@@ -260,7 +749,7 @@ void AgaveTaskReply::rawHttpTaskComplete()
         return;
     }
 
-    if (myGuide->getTaskID() != "authRevoke")
+    if (myGuide->getTaskType() != AgaveTaskType::AUTH_REVOKE)
     {
         if ((myManager->getInterfaceState() == RemoteDataInterfaceState::DISCONNECTING) ||
                 (myManager->getInterfaceState() == RemoteDataInterfaceState::DISCONNECTED))
@@ -278,77 +767,84 @@ void AgaveTaskReply::rawHttpTaskComplete()
         return;
     }    
 
+    if (downloadState != RequestState::GOOD)
+    {
+        //The reply was aborted because the data could not be written
+        processDatalessReply(downloadState);
+        return;
+    }
+
     if (testReply->error() != QNetworkReply::NoError)
     {
-        if (testReply->error() == 403)
+        RequestState errorState = interpretNetworkError(testReply);
+        if ((errorState == RequestState::DROPPED_CONNECTION) || (errorState == RequestState::LOST_INTERNET))
         {
-            processDatalessReply(RequestState::SERVICE_UNAVAILABLE);
+            retainPartialDownload();
         }
-        else if (testReply->error() == 401)
-        {
-            processDatalessReply(RequestState::REMOTE_SERVER_ERROR);
-        }
-        else if (testReply->error() == 3)
+        processDatalessReply(errorState);
+        return;
+    }
+
+    if (myGuide->getRequestType() == AgaveRequestType::AGAVE_DOWNLOAD)
+    {
+        //Most of the file has already been written as it arrived, this only takes the tail
+        if (!drainDownloadData())
         {
-            processDatalessReply(RequestState::LOST_INTERNET);
+            processDatalessReply(downloadState);
+            return;
         }
-        else if (testReply->error() == 2)
+
+        RequestState commitState = commitDownloadFile();
+        if (commitState != RequestState::GOOD)
         {
-            processDatalessReply(RequestState::DROPPED_CONNECTION);
+            processDatalessReply(commitState);
+            return;
         }
-        else if (testReply->error() == 203)
-        {
-            processDatalessReply(RequestState::FILE_NOT_FOUND);
-        }
-        else if (testReply->error() == 299)
-        {
-            processDatalessReply(RequestState::JOB_SYSTEM_DOWN);
-        }
-        else if (testReply->error() == 302)
-        {
-            processDatalessReply(RequestState::BAD_HTTP_REQUEST);
-        }
-        else
-        {
-            processDatalessReply(RequestState::GENERIC_NETWORK_ERROR);
 
-            qCDebug(remoteInterface, "Network Error detected: %d : %s", testReply->error(), qPrintable(testReply->errorString()));
-        }
+        emit haveDownloadReply(RequestState::GOOD, taskParamList.value("localDest"));
         return;
     }
 
-    QByteArray replyText = myReplyObject->readAll();
-
-    if (myGuide->getRequestType() == AgaveRequestType::AGAVE_DOWNLOAD)
+    if (myGuide->getRequestType() == AgaveRequestType::AGAVE_PIPE_DOWNLOAD)
     {
-        //TODO: consider a better way of doing this for larger files
-        QFile * fileHandle = new QFile(taskParamList.value("localDest"));
-        if (!fileHandle->open(QIODevice::WriteOnly))
+        if (!drainDownloadData())
         {
-            fileHandle->deleteLater();
-            processDatalessReply(RequestState::LOCAL_FILE_ERROR);
+            processDatalessReply(downloadState);
             return;
         }
 
-        fileHandle->write(replyText);
-        //TODO: There may be more errors here we need to catch
-
-        fileHandle->close();
-        fileHandle->deleteLater();
+        if ((expectedDownloadSize >= 0) && (pipeBuffer.size() != expectedDownloadSize))
+        {
+            qCDebug(remoteInterface, "ERROR: Download ended before all data arrived.");
+            retainPartialDownload();
+            processDatalessReply(RequestState::DROPPED_CONNECTION);
+            return;
+        }
 
-        emit haveDownloadReply(RequestState::GOOD, taskParamList.value("localDest"));
+        emit haveBufferDownloadReply(RequestState::GOOD, pipeBuffer);
         return;
     }
-    else if (myGuide->getRequestType() == AgaveRequestType::AGAVE_PIPE_DOWNLOAD)
+
+    if (myReplyObject->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt() == 304)
     {
-        //TODO: consider a better way of doing this for larger files
-        emit haveBufferDownloadReply(RequestState::GOOD, replyText);
+        replayCachedReply();
+        return;
+    }
 
+    //Listings are parsed as their data arrives, so only the tail is left
+    if (isStreamedListing())
+    {
+        finishStreamedListing();
         return;
     }
 
+    QByteArray replyText = myReplyObject->readAll();
+
+    QElapsedTimer parseClock;
+    parseClock.start();
     QJsonParseError parseError;
     QJsonDocument parseHandler = QJsonDocument::fromJson(replyText, &parseError);
+    statsRecord.parseMicros += parseClock.nsecsElapsed() / 1000;
 
     if (parseHandler.isNull())
     {
@@ -366,33 +862,10 @@ void AgaveTaskReply::rawHttpTaskComplete()
         return;
     }
 
-    if (myGuide->getTaskID() == "authRefresh")
+    switch (myGuide->getTaskType())
     {
-        processDatalessReply(RequestState::NOT_IMPLEMENTED);
-    }
-    else if (myGuide->getTaskID() == "dirListing")
-    {
-        QJsonValue expectedArray = retriveMainAgaveJSON(&parseHandler,"result");
-        if (!expectedArray.isArray())
-        {
-            processDatalessReply(RequestState::MISSING_REPLY_DATA);
-            return;
-        }
-        QJsonArray fileArray = expectedArray.toArray();
-        QList<FileMetaData> fileList;
-        for (auto itr = fileArray.constBegin(); itr != fileArray.constEnd(); itr++)
-        {
-            FileMetaData aFile = parseJSONfileMetaData((*itr).toObject());
-            if (aFile.getFileType() == FileType::INVALID)
-            {
-                processDatalessReply(RequestState::MISSING_REPLY_DATA);
-                return;
-            }
-            fileList.append(aFile);
-        }
-        emit haveLSReply(RequestState::GOOD, fileList);
-    }
-    else if ((myGuide->getTaskID() == "fileUpload") || (myGuide->getTaskID() == "filePipeUpload"))
+    case AgaveTaskType::FILE_UPLOAD:
+    case AgaveTaskType::FILE_PIPE_UPLOAD:
     {
         QJsonValue expectedObject = retriveMainAgaveJSON(&parseHandler,"result");
         FileMetaData aFile = parseJSONfileMetaData(expectedObject.toObject());
@@ -402,12 +875,12 @@ void AgaveTaskReply::rawHttpTaskComplete()
             return;
         }
         emit haveUploadReply(RequestState::GOOD, aFile);
+        break;
     }
-    else if (myGuide->getTaskID() == "fileDelete")
-    {
+    case AgaveTaskType::FILE_DELETE:
         emit haveDeleteReply(RequestState::GOOD, taskParamList.value("toDelete"));
-    }
-    else if (myGuide->getTaskID() == "newFolder")
+        break;
+    case AgaveTaskType::NEW_FOLDER:
     {
         QJsonValue expectedObject = retriveMainAgaveJSON(&parseHandler,"result");
         FileMetaData aFile = parseJSONfileMetaData(expectedObject.toObject());
@@ -417,8 +890,9 @@ void AgaveTaskReply::rawHttpTaskComplete()
             return;
         }
         emit haveMkdirReply(RequestState::GOOD, aFile);
+        break;
     }
-    else if (myGuide->getTaskID() == "renameFile")
+    case AgaveTaskType::RENAME_FILE:
     {
         QJsonValue expectedObject = retriveMainAgaveJSON(&parseHandler,"result");
         FileMetaData aFile = parseJSONfileMetaData(expectedObject.toObject());
@@ -428,8 +902,9 @@ void AgaveTaskReply::rawHttpTaskComplete()
             return;
         }
         emit haveRenameReply(RequestState::GOOD, aFile, taskParamList.value("fullName"));
+        break;
     }
-    else if (myGuide->getTaskID() == "fileCopy")
+    case AgaveTaskType::FILE_COPY:
     {
         QJsonValue expectedObject = retriveMainAgaveJSON(&parseHandler,"result");
         FileMetaData aFile = parseJSONfileMetaData(expectedObject.toObject());
@@ -439,8 +914,9 @@ void AgaveTaskReply::rawHttpTaskComplete()
             return;
         }
         emit haveCopyReply(RequestState::GOOD, aFile);
+        break;
     }
-    else if (myGuide->getTaskID() == "fileMove")
+    case AgaveTaskType::FILE_MOVE:
     {
         QJsonValue expectedObject = retriveMainAgaveJSON(&parseHandler,"result");
         FileMetaData aFile = parseJSONfileMetaData(expectedObject.toObject());
@@ -450,15 +926,9 @@ void AgaveTaskReply::rawHttpTaskComplete()
             return;
         }
         emit haveMoveReply(RequestState::GOOD, aFile, taskParamList.value("from"));
+        break;
     }
-    else if (myGuide->getTaskID() == "getJobList")
-    {
-        QJsonValue expectedObject = retriveMainAgaveJSON(&parseHandler,"result");
-        QList<RemoteJobData> jobList = parseJSONjobMetaData(expectedObject.toArray());
-
-        emit haveJobList(RequestState::GOOD, jobList);
-    }
-    else if (myGuide->getTaskID() == "getJobDetails")
+    case AgaveTaskType::GET_JOB_DETAILS:
     {
         QJsonValue expectedObject = retriveMainAgaveJSON(&parseHandler,"result");
         RemoteJobData jobData = parseJSONjobDetails(expectedObject.toObject());
@@ -467,34 +937,752 @@ void AgaveTaskReply::rawHttpTaskComplete()
             processDatalessReply(RequestState::MISSING_REPLY_DATA);
             return;
         }
+
+        if (myGuide->isCacheable())
+        {
+            AgaveCacheEntry * newEntry = new AgaveCacheEntry();
+            newEntry->jobData = jobData;
+            storeInReplyCache(newEntry, replyText.size());
+        }
         emit haveJobDetails(RequestState::GOOD, jobData);
+        break;
     }
-    else if (myGuide->getTaskID() == "stopJob")
-    {
+    case AgaveTaskType::STOP_JOB:
         emit haveStoppedJob(RequestState::GOOD);
-    }
-    else if (myGuide->getTaskID() == "deleteJob")
-    {
+        break;
+    case AgaveTaskType::DELETE_JOB:
         emit haveDeletedJob(RequestState::GOOD);
-    }
-    else if (myGuide->getTaskID() == "getAgaveList")
+        break;
+    case AgaveTaskType::GET_AGAVE_LIST:
     {
         //TODO More error checking here
         QJsonValue expectedArray = retriveMainAgaveJSON(&parseHandler,"result");
         QJsonArray appList = expectedArray.toArray();
         emit haveAgaveAppList(RequestState::GOOD, appList.toVariantList());
+        break;
+    }
+    default:
+        emit haveJobReply(RequestState::GOOD, parseHandler);
+        break;
+    }
+
+}
+
+AgaveListParse AgaveTaskReply::parseListReply(bool tokenFormat, QByteArray replyText)
+{
+    //This may run on a pool thread, so it uses only its arguments, which are copies, and not the task guide
+    AgaveListParse ret;
+    QElapsedTimer parseClock;
+    parseClock.start();
+
+    QJsonParseError parseError;
+    QJsonDocument parseHandler = QJsonDocument::fromJson(replyText, &parseError);
+
+    if (parseHandler.isNull())
+    {
+        ret.parseState = RequestState::JSON_PARSE_ERROR;
+        ret.parseMicros = parseClock.nsecsElapsed() / 1000;
+        return ret;
+    }
+
+    qCDebug(rawHTTP, "%s",qPrintable(parseHandler.toJson()));
+
+    ret.parseState = standardSuccessFailCheck(tokenFormat, &parseHandler);
+    if (ret.parseState == RequestState::GOOD)
+    {
+        QJsonValue expectedObject = retriveMainAgaveJSON(&parseHandler,"result");
+        ret.jobList = parseJSONjobMetaData(expectedObject.toArray());
+    }
+    ret.parseMicros = parseClock.nsecsElapsed() / 1000;
+    return ret;
+}
+
+bool AgaveTaskReply::isJobListPage()
+{
+    return ((myGuide->getTaskType() == AgaveTaskType::JOB_LIST_PAGE) ||
+            (myGuide->getTaskType() == AgaveTaskType::JOB_CHANGES_PAGE));
+}
+
+void AgaveTaskReply::readJobListPage()
+{
+    if (myReplyObject->error() != QNetworkReply::NoError)
+    {
+        AgaveListParse failedPage;
+        failedPage.parseState = interpretNetworkError(myReplyObject);
+        deliverListReply(failedPage);
+        return;
+    }
+
+    deliverListReply(parseListReply(myGuide->isTokenFormat(), myReplyObject->readAll()));
+}
+
+bool AgaveTaskReply::offloadJobListParse()
+{
+    //Job list pages may still be large, so big ones are parsed on the thread pool. This is decided before
+    //the reply is finished with, so that it is only deleted once the parse is done.
+    if (!myGuide->isInternal() || !isJobListPage()) return false;
+    if ((myReplyObject == nullptr) || (myReplyObject->error() != QNetworkReply::NoError)) return false;
+    if ((myManager->parseOffloadSize < 0) || (myReplyObject->bytesAvailable() < myManager->parseOffloadSize)) return false;
+
+    parseWatcher = new QFutureWatcher<AgaveListParse>(this);
+    QObject::connect(parseWatcher, SIGNAL(finished()), this, SLOT(offloadedParseComplete()));
+    parseWatcher->setFuture(QtConcurrent::run(&AgaveTaskReply::parseListReply, myGuide->isTokenFormat(), myReplyObject->readAll()));
+    return true;
+}
+
+void AgaveTaskReply::offloadedParseComplete()
+{
+    this->deleteLater();
+    deliverListReply(parseWatcher->result());
+}
+
+void AgaveTaskReply::deliverListReply(AgaveListParse parsedList)
+{
+    statsRecord.outcome = parsedList.parseState;
+    statsRecord.parseMicros += parsedList.parseMicros;
+
+    //Pages make up a job list, which the manager puts together
+    myManager->handleJobListPage(this, parsedList);
+}
+
+void AgaveTaskReply::batchItemDone(RequestState replyState)
+{
+    batchItemDone(replyState, FileMetaData());
+}
+
+void AgaveTaskReply::batchItemDone(RequestState replyState, FileMetaData newFileData)
+{
+    //The items of a batch are ordinary file requests, whose results the manager puts together
+    AgaveTaskReply * itemReply = qobject_cast<AgaveTaskReply *>(sender());
+    if (itemReply == nullptr) return;
+    myManager->handleBatchItem(itemReply, replyState, newFileData);
+}
+
+void AgaveTaskReply::sendBatchProgress()
+{
+    emit haveBatchProgress(batchItemsDone, batchItemsFailed, batchResults.size());
+}
+
+void AgaveTaskReply::rawListingDataReady()
+{
+    //Error replies and unchanged listings have no entries, and are dealt with when they finish
+    int httpStatus = myReplyObject->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    if ((httpStatus < 200) || (httpStatus >= 300)) return;
+
+    QByteArray newData = myReplyObject->readAll();
+    qCDebug(rawHTTP, "%s", qPrintable(QString::fromUtf8(newData)));
+
+    QElapsedTimer parseClock;
+    parseClock.start();
+    listingParser.addData(newData);
+    listingSoFar.append(listingParser.takeNewEntries());
+    statsRecord.parseMicros += parseClock.nsecsElapsed() / 1000;
+
+    int entriesWaiting = listingSoFar.size();
+    if (!isBatchesOnlyListing()) entriesWaiting -= listingBatchStart;
+    if (entriesWaiting >= listingBatchSize)
+    {
+        sendListingBatch();
+    }
+}
+
+void AgaveTaskReply::sendListingBatch()
+{
+    //A batches-only listing keeps just the entries not yet given out, and listingBatchStart counts those that were
+    if (isBatchesOnlyListing())
+    {
+        if (listingSoFar.isEmpty()) return;
+        listingBatchStart += listingSoFar.size();
+        emit haveLSPartialReply(RequestState::PENDING, listingSoFar);
+        listingSoFar.clear();
+        return;
+    }
+
+    if (listingSoFar.size() <= listingBatchStart) return;
+    emit haveLSPartialReply(RequestState::PENDING, listingSoFar.mid(listingBatchStart));
+    listingBatchStart = listingSoFar.size();
+}
+
+bool AgaveTaskReply::isStreamedListing()
+{
+    return ((myGuide->getTaskType() == AgaveTaskType::DIR_LISTING) || isBatchesOnlyListing());
+}
+
+bool AgaveTaskReply::isBatchesOnlyListing()
+{
+    return (myGuide->getTaskType() == AgaveTaskType::DIR_LISTING_BATCHES);
+}
+
+void AgaveTaskReply::finishStreamedListing()
+{
+    rawListingDataReady();
+
+    RequestState listingState = listingParser.getFinalState();
+    if (listingState != RequestState::GOOD)
+    {
+        processDatalessReply(listingState);
+        return;
+    }
+
+    //Once batches have gone out, the last of them follows, so that the batches make up the whole listing.
+    //A batches-only listing gives out all of its entries this way, and ends with an empty list.
+    if ((listingBatchStart > 0) || isBatchesOnlyListing())
+    {
+        sendListingBatch();
+    }
+
+    if (myGuide->isCacheable())
+    {
+        AgaveCacheEntry * newEntry = new AgaveCacheEntry();
+        newEntry->fileList = listingSoFar;
+        storeInReplyCache(newEntry, static_cast<int>(listingParser.getBytesRead()));
+    }
+    myManager->noteListingArrived();
+    emit haveLSReply(RequestState::GOOD, listingSoFar);
+}
+
+bool AgaveTaskReply::isExpiredTokenReply()
+{
+    if (tokenReplayed) return false;
+    if (myReplyObject == nullptr) return false;
+    if (myReplyObject->error() != QNetworkReply::AuthenticationRequiredError) return false;
+    return (myGuide->getHeaderType() == AuthHeaderType::TOKEN);
+}
+
+bool AgaveTaskReply::isRetryableFailure()
+{
+    if (myReplyObject == nullptr) return false;
+    if (retryCount + 1 >= myGuide->getMaxAttempts()) return false;
+
+    //Local failures, and requests we stopped ourselves, would only fail again
+    if (downloadState != RequestState::GOOD) return false;
+    if (myReplyObject->error() == QNetworkReply::OperationCanceledError) return false;
+
+    //Listing batches already given out cannot be taken back
+    if (listingBatchStart > 0) return false;
+
+    //The failure is judged from the error and status themselves, since refused access, conflicts and
+    //failed TLS handshakes all end up as a GENERIC_NETWORK_ERROR, and those would only fail again
+    QNetworkReply::NetworkError netError = myReplyObject->error();
+    int httpStatus = myReplyObject->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+
+    //An unavailable or overloaded server did nothing with the request, so any request can be sent again
+    if ((netError == QNetworkReply::ServiceUnavailableError) || (httpStatus == 503) || (httpStatus == 429)) return true;
+
+    //For other failures, the server may have acted on the request, so it is only sent again if that does no harm
+    if (!myGuide->isIdempotent()) return false;
+    if (httpStatus >= 500) return true;
+    if (httpStatus != 0) return false;
+
+    switch (netError)
+    {
+    case QNetworkReply::RemoteHostClosedError:
+    case QNetworkReply::TimeoutError:
+    case QNetworkReply::TemporaryNetworkFailureError:
+    case QNetworkReply::NetworkSessionFailedError:
+    case QNetworkReply::UnknownNetworkError:
+        return true;
+    default:
+        return false;
+    }
+}
+
+void AgaveTaskReply::prepareForReplay()
+{
+    //Download data already in hand is kept, and the next request asks only for the rest
+    //Download segments go on from the end of what they have written
+    if (downloadStarted && isDownloadSegment())
+    {
+        drainDownloadData();
+        noteSegmentProgress();
+        if ((downloadState == RequestState::GOOD) && (recordedDownloadBytes > taskParamList.value("rangeStart").toLongLong()))
+        {
+            taskParamList.insert("rangeStart", QByteArray::number(recordedDownloadBytes));
+        }
+    }
+    else if (downloadStarted)
+    {
+        drainDownloadData();
+
+        qint64 haveBytes = pipeBuffer.size();
+        if ((downloadHandle != nullptr) && downloadHandle->flush())
+        {
+            haveBytes = downloadHandle->pos();
+        }
+
+        if ((downloadState == RequestState::GOOD) && (haveBytes > 0) && (expectedDownloadSize > 0))
+        {
+            taskParamList.insert("resumeFrom", QByteArray::number(haveBytes));
+            taskParamList.insert("expectedSize", QByteArray::number(expectedDownloadSize));
+        }
+        else
+        {
+            taskParamList.remove("resumeFrom");
+            taskParamList.remove("expectedSize");
+            pipeBuffer.clear();
+        }
+    }
+
+    if (downloadHandle != nullptr)
+    {
+        downloadHandle->close();
+        downloadHandle->deleteLater();
+        downloadHandle = nullptr;
+    }
+    downloadStarted = false;
+    downloadState = RequestState::GOOD;
+
+    listingParser.reset();
+    listingSoFar.clear();
+
+    myReplyObject->deleteLater();
+    myReplyObject = nullptr;
+}
+
+void AgaveTaskReply::keepValidatedEntry(AgaveCacheEntry * cachedReply)
+{
+    //The lists in the entry are implicitly shared, so the copy costs nothing
+    if (validatedEntry == nullptr) validatedEntry = new AgaveCacheEntry();
+    *validatedEntry = *cachedReply;
+}
+
+void AgaveTaskReply::replayCachedReply()
+{
+    //The server says nothing has changed, so the earlier result is given again without parsing anything
+    if (validatedEntry == nullptr)
+    {
+        qCDebug(remoteInterface, "ERROR: Server says unchanged, but no earlier result was sent for.");
+        processDatalessReply(RequestState::MISSING_REPLY_DATA);
+        return;
+    }
+
+    if (myGuide->getTaskType() == AgaveTaskType::DIR_LISTING)
+    {
+        myManager->noteListingArrived();
+        emit haveLSReply(RequestState::GOOD, validatedEntry->fileList);
+    }
+    else if (myGuide->getTaskType() == AgaveTaskType::GET_JOB_DETAILS)
+    {
+        emit haveJobDetails(RequestState::GOOD, validatedEntry->jobData);
     }
     else
     {
-        emit haveJobReply(RequestState::GOOD, parseHandler);
+        processDatalessReply(RequestState::INTERNAL_ERROR);
+    }
+}
+
+void AgaveTaskReply::storeInReplyCache(AgaveCacheEntry * newEntry, int replySize)
+{
+    newEntry->eTag = myReplyObject->rawHeader("ETag");
+    newEntry->lastModified = myReplyObject->rawHeader("Last-Modified");
+    myManager->storeCachedReply(AgaveHandler::getRequestKey(myGuide, &taskParamList), newEntry, replySize);
+}
+
+void AgaveTaskReply::rawDownloadDataReady()
+{
+    if (!drainDownloadData())
+    {
+        myReplyObject->abort();
+    }
+}
+
+bool AgaveTaskReply::drainDownloadData()
+{
+    if (downloadState != RequestState::GOOD) return false;
+
+    //Error replies carry a short message body, which must not end up in the file
+    int httpStatus = myReplyObject->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    if ((httpStatus != 0) && ((httpStatus < 200) || (httpStatus >= 300)))
+    {
+        myReplyObject->readAll();
+        return true;
+    }
+
+    if (!downloadStarted)
+    {
+        //Nothing can be done before the reply headers say what is arriving
+        if (httpStatus == 0) return true;
+        downloadStarted = true;
+        if (!beginDownloadData(httpStatus)) return false;
+    }
+
+    if (myGuide->getRequestType() == AgaveRequestType::AGAVE_PIPE_DOWNLOAD)
+    {
+        pipeBuffer.append(myReplyObject->readAll());
+        return true;
+    }
+
+    qint64 rangeEnd = -1;
+    if (isDownloadSegment())
+    {
+        rangeEnd = taskParamList.value("rangeEnd").toLongLong();
+    }
+
+    while (myReplyObject->bytesAvailable() > 0)
+    {
+        qint64 toRead = downloadChunkSize;
+        if (rangeEnd >= 0)
+        {
+            toRead = qMin(toRead, rangeEnd + 1 - downloadHandle->pos());
+            if (toRead <= 0)
+            {
+                downloadState = RequestState::MISSING_REPLY_DATA;
+                return false;
+            }
+        }
+
+        QByteArray dataChunk = myReplyObject->read(toRead);
+        if (dataChunk.isEmpty()) break;
+
+        if (downloadHandle->write(dataChunk) != dataChunk.size())
+        {
+            qCDebug(remoteInterface, "ERROR: Unable to write download data: %s", qPrintable(downloadHandle->errorString()));
+            downloadState = RequestState::LOCAL_FILE_ERROR;
+            return false;
+        }
+    }
+
+    if (downloadHandle->pos() - recordedDownloadBytes >= downloadRecordInterval)
+    {
+        if (isDownloadSegment())
+        {
+            noteSegmentProgress();
+        }
+        else
+        {
+            writeDownloadRecord();
+        }
+    }
+    return true;
+}
+
+bool AgaveTaskReply::beginDownloadData(int httpStatus)
+{
+    QByteArray contentRange = myReplyObject->rawHeader("Content-Range");
+    qint64 rangeBegin = 0;
+    if (httpStatus == 206)
+    {
+        //Content-Range is of the form: bytes first-last/total
+        rangeBegin = contentRange.mid(6, contentRange.indexOf('-') - 6).trimmed().toLongLong();
+        bool sizeKnown = false;
+        expectedDownloadSize = contentRange.mid(contentRange.lastIndexOf('/') + 1).toLongLong(&sizeKnown);
+        if (!sizeKnown) expectedDownloadSize = -1;
+    }
+    else
+    {
+        QVariant contentLength = myReplyObject->header(QNetworkRequest::ContentLengthHeader);
+        if (contentLength.isValid()) expectedDownloadSize = contentLength.toLongLong();
+    }
+
+    //For encoded replies, the length given is not the length of the data we get
+    QByteArray contentEncoding = myReplyObject->rawHeader("Content-Encoding");
+    if (!contentEncoding.isEmpty() && (contentEncoding != "identity"))
+    {
+        expectedDownloadSize = -1;
+    }
+
+    qint64 writeOffset = 0;
+
+    if (isDownloadSegment())
+    {
+        //A server ignoring the Range header sends the whole file, which cannot be placed at an offset
+        if (httpStatus != 206)
+        {
+            qCDebug(remoteInterface, "ERROR: Remote server did not honor ranged download request.");
+            downloadState = RequestState::BAD_HTTP_REQUEST;
+            return false;
+        }
+        if (QByteArray::number(expectedDownloadSize) != taskParamList.value("remoteSize"))
+        {
+            qCDebug(remoteInterface, "ERROR: Remote file size changed during segmented download.");
+            downloadState = RequestState::MISSING_REPLY_DATA;
+            return false;
+        }
+        writeOffset = taskParamList.value("rangeStart").toLongLong();
+    }
+    else if (taskParamList.contains("resumeFrom"))
+    {
+        if (httpStatus == 206)
+        {
+            writeOffset = taskParamList.value("resumeFrom").toLongLong();
+            qint64 priorSize = taskParamList.value("expectedSize").toLongLong();
+
+            //If the remote file is not the one the partial data came from, the partial data is useless
+            if ((rangeBegin != writeOffset) || (expectedDownloadSize != priorSize))
+            {
+                qCDebug(remoteInterface, "ERROR: Remote file changed since partial download.");
+                downloadState = RequestState::MISSING_REPLY_DATA;
+                return false;
+            }
+            qCDebug(remoteInterface, "Resuming download of %s at byte %lld", taskParamList.value("remoteName").constData(), writeOffset);
+        }
+        else
+        {
+            qCDebug(remoteInterface, "Remote server ignored resume request, restarting download.");
+            pipeBuffer.clear();
+        }
+    }
+
+    if (myGuide->getRequestType() == AgaveRequestType::AGAVE_PIPE_DOWNLOAD) return true;
+
+    downloadHandle = new QFile(getPartialDownloadName(), this);
+    if (isDownloadSegment())
+    {
+        //The parent download has already created and sized the file
+        if (!downloadHandle->open(QIODevice::ReadWrite) || !downloadHandle->seek(writeOffset))
+        {
+            downloadState = RequestState::LOCAL_FILE_ERROR;
+        }
+    }
+    else if (writeOffset > 0)
+    {
+        //Anything past the recorded byte count may not have been completely written
+        if (!downloadHandle->open(QIODevice::ReadWrite) || !downloadHandle->resize(writeOffset) || !downloadHandle->seek(writeOffset))
+        {
+            downloadState = RequestState::LOCAL_FILE_ERROR;
+        }
+    }
+    else if (!downloadHandle->open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        downloadState = RequestState::LOCAL_FILE_ERROR;
+    }
+
+    if (downloadState != RequestState::GOOD)
+    {
+        qCDebug(remoteInterface, "ERROR: Unable to open download destination: %s", qPrintable(downloadHandle->fileName()));
+        return false;
+    }
+
+    if (isDownloadSegment())
+    {
+        recordedDownloadBytes = writeOffset;
+    }
+    else
+    {
+        writeDownloadRecord();
+    }
+    return true;
+}
+
+void AgaveTaskReply::retainPartialDownload()
+{
+    //A segment records how far it got in its parent's record, and the parent keeps the file
+    if (isDownloadSegment())
+    {
+        drainDownloadData();
+        noteSegmentProgress();
+        return;
+    }
+    if (!taskParamList.contains("remoteName")) return;
+
+    //Take whatever arrived before the connection failed
+    drainDownloadData();
+    if (downloadState != RequestState::GOOD) return;
+
+    if (myGuide->getRequestType() == AgaveRequestType::AGAVE_DOWNLOAD)
+    {
+        keepPartialDownload = true;
+    }
+    else if ((myGuide->getRequestType() == AgaveRequestType::AGAVE_PIPE_DOWNLOAD) && !pipeBuffer.isEmpty() && (expectedDownloadSize > 0))
+    {
+        myManager->retainPartialBuffer(QString::fromUtf8(taskParamList.value("remoteName")), pipeBuffer, expectedDownloadSize);
+    }
+}
+
+RequestState AgaveTaskReply::finishDownloadSegment()
+{
+    if (downloadState != RequestState::GOOD) return downloadState;
+    if (myReplyObject == nullptr) return RequestState::INTERNAL_ERROR;
+
+    //Whatever arrived before a failure is kept, and recorded, so that the segment can go on from there
+    bool drainGood = drainDownloadData();
+    noteSegmentProgress();
+    if (myReplyObject->error() != QNetworkReply::NoError) return interpretNetworkError(myReplyObject);
+    if (!drainGood) return downloadState;
+    if (downloadHandle == nullptr) return RequestState::MISSING_REPLY_DATA;
+
+    qint64 endPos = downloadHandle->pos();
+    downloadHandle->close();
+
+    if (endPos != taskParamList.value("rangeEnd").toLongLong() + 1)
+    {
+        qCDebug(remoteInterface, "ERROR: Download segment ended early.");
+        return RequestState::DROPPED_CONNECTION;
     }
+    return RequestState::GOOD;
+}
 
+bool AgaveTaskReply::isDownloadSegment()
+{
+    return taskParamList.contains("rangeStart");
+}
+
+RequestState AgaveTaskReply::commitDownloadFile()
+{
+    if (downloadHandle == nullptr) return RequestState::LOCAL_FILE_ERROR;
+
+    if ((expectedDownloadSize >= 0) && (downloadHandle->pos() != expectedDownloadSize))
+    {
+        //The reply ended cleanly, but short, which is kept for a later resume
+        qCDebug(remoteInterface, "ERROR: Download ended before all data arrived.");
+        keepPartialDownload = true;
+        return RequestState::DROPPED_CONNECTION;
+    }
+
+    downloadHandle->close();
+    if (downloadHandle->error() != QFileDevice::NoError)
+    {
+        return RequestState::LOCAL_FILE_ERROR;
+    }
+
+    if (!downloadHandle->rename(QString::fromUtf8(taskParamList.value("localDest"))))
+    {
+        qCDebug(remoteInterface, "ERROR: Unable to move finished download into place: %s", qPrintable(downloadHandle->errorString()));
+        return RequestState::LOCAL_FILE_ERROR;
+    }
+
+    downloadCommitted = true;
+    QFile::remove(getDownloadRecordName());
+    return RequestState::GOOD;
+}
+
+void AgaveTaskReply::discardPartialDownload()
+{
+    if (downloadHandle != nullptr) downloadHandle->close();
+    QFile::remove(getPartialDownloadName());
+    QFile::remove(getDownloadRecordName());
+}
+
+void AgaveTaskReply::writeDownloadRecord()
+{
+    if ((downloadHandle == nullptr) || !downloadHandle->isOpen()) return;
+
+    //The byte count is only recorded once the data is actually in the file
+    if (!downloadHandle->flush()) return;
+    recordedDownloadBytes = downloadHandle->pos();
+
+    QJsonObject downloadRecord;
+    downloadRecord.insert("remotePath", QString::fromUtf8(taskParamList.value("remoteName")));
+    downloadRecord.insert("expectedSize", static_cast<double>(expectedDownloadSize));
+    downloadRecord.insert("bytesDone", static_cast<double>(recordedDownloadBytes));
+
+    QSaveFile recordFile(getDownloadRecordName());
+    if (!recordFile.open(QIODevice::WriteOnly)) return;
+    recordFile.write(QJsonDocument(downloadRecord).toJson(QJsonDocument::Compact));
+    recordFile.commit();
+}
+
+void AgaveTaskReply::noteSegmentProgress()
+{
+    if (!isDownloadSegment() || (downloadHandle == nullptr) || !downloadHandle->isOpen()) return;
+
+    //The byte count is only recorded once the data is actually in the file
+    if (!downloadHandle->flush()) return;
+    recordedDownloadBytes = downloadHandle->pos();
+
+    AgaveTaskReply * parentDownload = qobject_cast<AgaveTaskReply *>(parent());
+    if (parentDownload == nullptr) return;
+    int segmentNum = taskParamList.value("segmentNum").toInt();
+    if ((segmentNum < 0) || (segmentNum >= parentDownload->segmentStarts.size())) return;
+
+    parentDownload->segmentBytesDone[segmentNum] = recordedDownloadBytes - parentDownload->segmentStarts.at(segmentNum);
+    parentDownload->writeSegmentRecord();
+}
+
+void AgaveTaskReply::writeSegmentRecord()
+{
+    QJsonArray segmentList;
+    for (int i = 0; i < segmentStarts.size(); i++)
+    {
+        QJsonObject aSegment;
+        aSegment.insert("start", static_cast<double>(segmentStarts.at(i)));
+        aSegment.insert("end", static_cast<double>(segmentEnds.at(i)));
+        aSegment.insert("bytesDone", static_cast<double>(segmentBytesDone.at(i)));
+        segmentList.append(aSegment);
+    }
+
+    QJsonObject downloadRecord;
+    downloadRecord.insert("remotePath", QString::fromUtf8(taskParamList.value("remoteName")));
+    downloadRecord.insert("expectedSize", static_cast<double>(taskParamList.value("remoteSize").toLongLong()));
+    downloadRecord.insert("segments", segmentList);
+
+    QSaveFile recordFile(getDownloadRecordName());
+    if (!recordFile.open(QIODevice::WriteOnly)) return;
+    recordFile.write(QJsonDocument(downloadRecord).toJson(QJsonDocument::Compact));
+    recordFile.commit();
+}
+
+QJsonObject AgaveTaskReply::readDownloadRecord(QString localDest)
+{
+    QFile recordFile(localDest + ".part.info");
+    if (!recordFile.open(QIODevice::ReadOnly)) return QJsonObject();
+
+    QJsonDocument recordDoc = QJsonDocument::fromJson(recordFile.readAll());
+    return recordDoc.object();
+}
+
+QString AgaveTaskReply::getPartialDownloadName()
+{
+    QString ret = QString::fromUtf8(taskParamList.value("localDest"));
+    ret.append(".part");
+    return ret;
+}
+
+QString AgaveTaskReply::getDownloadRecordName()
+{
+    QString ret = getPartialDownloadName();
+    ret.append(".info");
+    return ret;
+}
+
+RequestState AgaveTaskReply::interpretNetworkError(QNetworkReply * theReply)
+{
+    if (theReply->error() == QNetworkReply::NoError)
+    {
+        return RequestState::GOOD;
+    }
+    else if (theReply->error() == 403)
+    {
+        return RequestState::SERVICE_UNAVAILABLE;
+    }
+    else if (theReply->error() == 401)
+    {
+        return RequestState::REMOTE_SERVER_ERROR;
+    }
+    else if (theReply->error() == 3)
+    {
+        return RequestState::LOST_INTERNET;
+    }
+    else if (theReply->error() == 2)
+    {
+        return RequestState::DROPPED_CONNECTION;
+    }
+    else if (theReply->error() == 203)
+    {
+        return RequestState::FILE_NOT_FOUND;
+    }
+    else if (theReply->error() == 299)
+    {
+        return RequestState::JOB_SYSTEM_DOWN;
+    }
+    else if (theReply->error() == 302)
+    {
+        return RequestState::BAD_HTTP_REQUEST;
+    }
+
+    qCDebug(remoteInterface, "Network Error detected: %d : %s", theReply->error(), qPrintable(theReply->errorString()));
+    return RequestState::GENERIC_NETWORK_ERROR;
 }
 
 RequestState AgaveTaskReply::standardSuccessFailCheck(AgaveTaskGuide * taskGuide, QJsonDocument * parsedDoc)
+{
+    return standardSuccessFailCheck(taskGuide->isTokenFormat(), parsedDoc);
+}
+
+RequestState AgaveTaskReply::standardSuccessFailCheck(bool tokenFormat, QJsonDocument * parsedDoc)
 {
     //In Agave TOKEN uses a different output form
-    if (taskGuide->isTokenFormat())
+    if (tokenFormat)
     {
         if (parsedDoc->object().contains("error"))
         {
@@ -557,7 +1745,8 @@ FileMetaData AgaveTaskReply::parseJSONfileMetaData(QJsonObject fileNameValuePair
         ret.setType(FileType::FILE);
     }
     //TODO: consider more validity checks here
-    int fileLength = fileNameValuePairs.value("length").toInt();
+    //Note: toInt() would discard lengths of files over 2GB
+    qint64 fileLength = static_cast<qint64>(fileNameValuePairs.value("length").toDouble());
     ret.setSize(fileLength);
 
     return ret;
@@ -739,11 +1928,14 @@ bool AgaveTaskReply::anySignalConnect()
 
     if (isSignalConnected(QMetaMethod::fromSignal(&AgaveTaskReply::haveAuthReply))) return true;
     if (isSignalConnected(QMetaMethod::fromSignal(&AgaveTaskReply::haveLSReply))) return true;
+    if (isSignalConnected(QMetaMethod::fromSignal(&AgaveTaskReply::haveLSPartialReply))) return true;
 
     if (isSignalConnected(QMetaMethod::fromSignal(&AgaveTaskReply::haveDeleteReply))) return true;
     if (isSignalConnected(QMetaMethod::fromSignal(&AgaveTaskReply::haveMoveReply))) return true;
     if (isSignalConnected(QMetaMethod::fromSignal(&AgaveTaskReply::haveCopyReply))) return true;
     if (isSignalConnected(QMetaMethod::fromSignal(&AgaveTaskReply::haveRenameReply))) return true;
+    if (isSignalConnected(QMetaMethod::fromSignal(&AgaveTaskReply::haveBatchProgress))) return true;
+    if (isSignalConnected(QMetaMethod::fromSignal(&AgaveTaskReply::haveBatchReply))) return true;
 
     if (isSignalConnected(QMetaMethod::fromSignal(&AgaveTaskReply::haveMkdirReply))) return true;
 
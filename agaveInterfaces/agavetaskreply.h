@@ -37,29 +37,62 @@
 #define AGAVETASKREPLY_H
 
 #include "remotedatainterface.h"
+#include "agavelistingparser.h"
+#include "agaverequeststats.h"
 
 #include <QNetworkReply>
 
+#include <QFile>
+#include <QSaveFile>
 #include <QTimer>
 #include <QMetaMethod>
 #include <QJsonArray>
+#include <QJsonObject>
+#include <QFutureWatcher>
+#include <QPointer>
+#include <QElapsedTimer>
+#include <QVector>
+#include <QWeakPointer>
+#include <QSharedPointer>
 
 class AgaveHandler;
 class AgaveTaskGuide;
+class AgaveCacheEntry;
+class AgaveHandleLink;
+
+/*! \brief The AgaveListParse is the parsed result of one page of a job list, for use internal to the AgaveTaskReply.
+ *
+ *  It is made by a static parse, which may run on another thread, and is then given out by the reply on its own thread.
+ */
+
+class AgaveListParse
+{
+public:
+    RequestState parseState = RequestState::INTERNAL_ERROR;
+    QList<RemoteJobData> jobList;
+    qint64 parseMicros = 0;
+};
 
 class AgaveTaskReply : public RemoteDataReply
 {
     Q_OBJECT
 
     friend class AgaveHandler;
+    friend class AgaveListingParser;
 
 public:
     explicit AgaveTaskReply(AgaveTaskGuide * theGuide, QNetworkReply *newReply, AgaveHandler * theManager, QObject *parent = nullptr);
     explicit AgaveTaskReply(AgaveTaskGuide * theGuide, RequestState passThruErrorState, AgaveHandler * theManager, QObject *parent = nullptr);
+    explicit AgaveTaskReply(AgaveTaskGuide * theGuide, QMap<QString, QByteArray> taskVars, AgaveHandler * theManager, QObject *parent = nullptr);
+    explicit AgaveTaskReply(AgaveHandler * theManager, QObject *parent = nullptr);
     ~AgaveTaskReply();
 
     virtual void setAsUnconnectedReply();
 
+public slots:
+    virtual void cancel();
+    virtual void setDeadline(int deadlineMillis);
+
 protected:
     QMap<QString, QByteArray> *getTaskParamList();
 
@@ -67,7 +100,10 @@ protected:
     //Agave specific:
     AgaveTaskGuide * getTaskGuide();
 
+    static RequestState interpretNetworkError(QNetworkReply * theReply);
+    static QJsonObject readDownloadRecord(QString localDest);
     static RequestState standardSuccessFailCheck(AgaveTaskGuide * taskGuide, QJsonDocument * parsedDoc);
+    static RequestState standardSuccessFailCheck(bool tokenFormat, QJsonDocument * parsedDoc);
     static FileMetaData parseJSONfileMetaData(QJsonObject fileNameValuePairs);
     static QList<RemoteJobData> parseJSONjobMetaData(QJsonArray rawJobList);
     static RemoteJobData parseJSONjobDetails(QJsonObject rawJobData, bool haveDetails = true);
@@ -77,6 +113,7 @@ protected:
     static QJsonValue retriveMainAgaveJSON(QJsonDocument * parsedDoc, QList<QString> keyList);
     static QJsonValue recursiveJSONdig(QJsonValue currObj, QList<QString> * keyList, int i);
 
+    static AgaveListParse parseListReply(bool tokenFormat, QByteArray replyText);
     static QDateTime parseAgaveTime(QString agaveTime);
     static QMap<QString, QString> convertVarMapToString(QMap<QString, QVariant> inMap);
 
@@ -91,9 +128,59 @@ protected slots:
 private slots:
     void rawPassThruTaskComplete();
     void rawHttpTaskComplete();
+    void rawDownloadDataReady();
+    void rawListingDataReady();
+    void offloadedParseComplete();
+    void batchItemDone(RequestState replyState);
+    void batchItemDone(RequestState replyState, FileMetaData newFileData);
+    void deadlinePassed();
+    void finishStoppedRequest();
+    void sendHedge();
+    void hedgeFinished();
+    void rawFirstByte();
+    void rawDownloadProgress(qint64 bytesReceived, qint64 bytesTotal);
+    void rawUploadProgress(qint64 bytesSent, qint64 bytesTotal);
 
 private:
     bool performInitPointerCheck(AgaveTaskGuide * theGuide, AgaveHandler * theManager);
+    void attachNetworkReply(QNetworkReply * newReply);
+    void forwardSignalsFrom(AgaveTaskReply * sourceReply, Qt::ConnectionType connectionType);
+    void followReply(AgaveTaskReply * leaderReply);
+    void releaseLinkedRequest();
+    void stopRequest(RequestState newStopState);
+    void stopIfUnwatched();
+    void startDeadline(int deadlineMillis);
+    void dropHedge();
+    void markRequestFinished();
+    bool canTakeFollowers();
+    void keepValidatedEntry(AgaveCacheEntry * cachedReply);
+    void replayCachedReply();
+    bool isExpiredTokenReply();
+    bool isRetryableFailure();
+    void prepareForReplay();
+    void storeInReplyCache(AgaveCacheEntry * newEntry, int replySize);
+    bool isJobListPage();
+    bool offloadJobListParse();
+    void readJobListPage();
+    void deliverListReply(AgaveListParse parsedList);
+    bool isStreamedListing();
+    bool isBatchesOnlyListing();
+    void finishStreamedListing();
+    void sendListingBatch();
+    void sendBatchProgress();
+
+    bool drainDownloadData();
+    bool beginDownloadData(int httpStatus);
+    RequestState commitDownloadFile();
+    RequestState finishDownloadSegment();
+    bool isDownloadSegment();
+    void retainPartialDownload();
+    void discardPartialDownload();
+    void writeDownloadRecord();
+    void noteSegmentProgress();
+    void writeSegmentRecord();
+    QString getPartialDownloadName();
+    QString getDownloadRecordName();
 
     void signalConnectDelay();
     bool anySignalConnect();
@@ -105,12 +192,97 @@ private:
     AgaveTaskGuide * myGuide = nullptr;
     QNetworkReply * myReplyObject = nullptr;
 
+    //For a request from another thread, this reply stays on the caller's thread, and gets its results through the relay
+    QSharedPointer<AgaveHandleLink> handleLink;
+    AgaveTaskReply * handleRelay = nullptr;
+    AgaveTaskGuide * handleGuide = nullptr;
+
+    //Large job lists are parsed on the thread pool, from a copy of the reply data, and this reply waits for the result
+    QFutureWatcher<AgaveListParse> * parseWatcher = nullptr;
+
+    //Listings are parsed as they arrive, and entries given out in batches
+    static const int listingBatchSize = 1000;
+    AgaveListingParser listingParser;
+    QList<FileMetaData> listingSoFar;
+    int listingBatchStart = 0;
+
     //delayed dataless reply store:
     bool hasPendingReply = false;
     RequestState pendingReply = RequestState::INTERNAL_ERROR;
 
     bool expectsSignalConnect = true;
 
+    //A reply which follows another's request, and the request, which is only stopped when no one follows it
+    QPointer<AgaveTaskReply> followedReply;
+
+    //A stopped request gives the state it was stopped with, once, in place of its result
+    RequestState stopState = RequestState::GOOD;
+    bool requestFinished = false;
+    QTimer * deadlineTimer = nullptr;
+    bool explicitDeadline = false;
+
+    //A slow read may be sent a second time, as a hedge, and whichever answers first is used
+    QElapsedTimer sendClock;
+    QTimer * hedgeTimer = nullptr;
+    QNetworkReply * hedgeReplyObject = nullptr;
+    QElapsedTimer hedgeClock;
+
+    //Each request measures itself, and is recorded in the manager's stats as it is deleted
+    QWeakPointer<AgaveRequestStats> statsSink;
+    AgaveRequestRecord statsRecord;
+    QElapsedTimer requestClock;
+
+    //A cacheable read sent with validators keeps the entry they came from, in case the server says it is unchanged
+    AgaveCacheEntry * validatedEntry = nullptr;
+
+    //For a buffer upload, the caller's data, shared rather than copied, so that it can be sent again
+    QByteArray uploadData;
+
+    //A request refused for an expired token is sent once more, after the token is refreshed
+    QByteArray sentWithToken;
+    bool tokenReplayed = false;
+
+    //Failures which may pass are retried, as the task guide allows, invisibly to the reply's user
+    int retryCount = 0;
+
+    //Downloads to file are streamed into a temporary file, renamed on success
+    //A record beside the temporary file notes how much of it is good, so a failed download can resume
+    QFile * downloadHandle = nullptr;
+    RequestState downloadState = RequestState::GOOD;
+    const qint64 downloadChunkSize = 64 * 1024;
+    bool downloadStarted = false;
+    bool downloadCommitted = false;
+    bool keepPartialDownload = false;
+    qint64 expectedDownloadSize = -1;
+    qint64 recordedDownloadBytes = 0;
+    const qint64 downloadRecordInterval = 8 * 1024 * 1024;
+    QByteArray pipeBuffer;
+
+    //For replies which wait on several sub-requests, such as a segmented download
+    int pendingSubtasks = 0;
+    RequestState subtaskState = RequestState::GOOD;
+    FileMetaData subtaskFileResult;
+
+    //For a segmented download, the range of each segment, and how much of it is safely in the file
+    QVector<qint64> segmentStarts;
+    QVector<qint64> segmentEnds;
+    QVector<qint64> segmentBytesDone;
+
+    //For a paged listing, pages which arrive ahead of those before them wait here, to be given out in order
+    QMap<qint64, QList<FileMetaData>> pagesWaiting;
+    qint64 nextPageToSend = 0;
+    qint64 nextPageToGive = 0;
+    qint64 lastListingPage = -1;
+
+    //For a job list, the jobs of the pages so far
+    QList<RemoteJobData> jobListSoFar;
+
+    //For a batch of file operations, the result of each item, and how far the batch has got
+    QList<RemoteFileOpResult> batchResults;
+    int nextBatchItem = 0;
+    int batchItemsDone = 0;
+    int batchItemsFailed = 0;
+
     QMap<QString, QByteArray> taskParamList;
 };
 
@@ -92,7 +92,7 @@ void FileMetaData::setFullFilePath(QString fullPath)
     }
 }
 
-void FileMetaData::setSize(int newSize)
+void FileMetaData::setSize(qint64 newSize)
 {
     fileSize = newSize;
 }
@@ -119,7 +119,7 @@ QString FileMetaData::getContainingPath() const
     return fullContainingPath;
 }
 
-int FileMetaData::getSize() const
+qint64 FileMetaData::getSize() const
 {
     return fileSize;
 }
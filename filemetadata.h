@@ -37,6 +37,7 @@
 #define FILEMETADATA_H
 
 #include <QStringList>
+#include <QMetaType>
 
 enum class FileType {FILE, DIR, SIM_LINK, INVALID, NIL}; //Add more as needed
 
@@ -49,13 +50,13 @@ public:
     void copyDataFrom(const FileMetaData &toCopy);
 
     void setFullFilePath(QString fullPath);
-    void setSize(int newSize);
+    void setSize(qint64 newSize);
     void setType(FileType newType);
 
     QString getFullPath() const;
     QString getFileName() const;
     QString getContainingPath() const;
-    int getSize() const;
+    qint64 getSize() const;
     FileType getFileType() const;
     QString getFileTypeString() const;
 
@@ -68,8 +69,10 @@ private:
     //Add more members as needed, all must have reasonable defaults, and be handled in copy constructor
     QString fullContainingPath; //ie. full path without this files own name
     QString fileName;
-    int fileSize = 0; //in bytes?
+    qint64 fileSize = 0; //in bytes
     FileType myType = FileType::NIL;
 };
 
+Q_DECLARE_METATYPE(FileMetaData)
+
 #endif // FILEMETADATA_H
@@ -274,6 +274,62 @@ void FileOperator::getRenameReply(RequestState replyState, FileMetaData newFileD
     }
 }
 
+void FileOperator::sendBatchReq(QList<RemoteFileOperation> operationList)
+{
+    if (myState != FileOperatorState::IDLE) return;
+    if (operationList.isEmpty()) return;
+
+    qCDebug(fileManager, "Starting batch of %d file operations", operationList.size());
+    RemoteDataReply * theReply = myInterface->batchFileOperations(operationList);
+
+    QObject::connect(theReply, SIGNAL(haveBatchProgress(int,int,int)),
+                     this, SIGNAL(batchOpProgress(int,int,int)));
+    QObject::connect(theReply, SIGNAL(haveBatchReply(RequestState,QList<RemoteFileOpResult>)),
+                     this, SLOT(getBatchReply(RequestState,QList<RemoteFileOpResult>)));
+    myState = FileOperatorState::ACTIVE;
+    emit fileOpStarted();
+}
+
+void FileOperator::getBatchReply(RequestState replyState, QList<RemoteFileOpResult> itemResults)
+{
+    myState = FileOperatorState::IDLE;
+
+    //Folders already being refreshed are not asked for again, so shared parents are only listed once
+    int itemsGood = 0;
+    for (const RemoteFileOpResult &aResult : itemResults)
+    {
+        if (aResult.resultState != RequestState::GOOD) continue;
+        itemsGood++;
+
+        switch (aResult.theOperation.opType)
+        {
+        case FileOperationType::REMOVE:
+            lsClosestNodeToParent(aResult.theOperation.remotePath);
+            break;
+        case FileOperationType::MOVE:
+            lsClosestNodeToParent(aResult.theOperation.remotePath);
+            lsClosestNode(aResult.newFileData.getFullPath());
+            break;
+        case FileOperationType::COPY:
+            lsClosestNode(aResult.newFileData.getFullPath());
+            break;
+        case FileOperationType::RENAME:
+            lsClosestNodeToParent(aResult.theOperation.remotePath);
+            lsClosestNodeToParent(aResult.newFileData.getFullPath());
+            break;
+        }
+    }
+
+    if (replyState == RequestState::GOOD)
+    {
+        emit fileOpDone(replyState, QString("All %1 file operations successful").arg(itemsGood));
+    }
+    else
+    {
+        emitStdFileOpErr(QString("%1 of %2 file operations done").arg(itemsGood).arg(itemResults.size()), replyState);
+    }
+}
+
 void FileOperator::sendCreateFolderReq(const FileNodeRef &selectedNode, QString newName)
 {
     if (myState != FileOperatorState::IDLE) return;
@@ -326,7 +382,7 @@ void FileOperator::sendUploadReq(const FileNodeRef &uploadTarget, QString localF
     emit fileOpStarted();
 }
 
-void FileOperator::sendUploadBuffReq(const FileNodeRef &uploadTarget, QByteArray fileBuff, QString newName)
+void FileOperator::sendUploadBuffReq(const FileNodeRef &uploadTarget, const QByteArray &fileBuff, QString newName)
 {
     if (myState != FileOperatorState::IDLE) return;
     if (!uploadTarget.fileNodeExtant()) return;
@@ -368,7 +424,7 @@ void FileOperator::sendDownloadReq(const FileNodeRef &targetFile, QString localD
 
     qCDebug(fileManager, "Starting download procedure: %s to %s", qPrintable(targetFile.getFullPath()),
            qPrintable(localDest));
-    RemoteDataReply * theReply = myInterface->downloadFile(localDest, targetFile.getFullPath());
+    RemoteDataReply * theReply = myInterface->downloadFile(localDest, targetFile.getFullPath(), targetFile.getSize());
 
     QObject::connect(theReply, SIGNAL(haveDownloadReply(RequestState, QString)),
                      this, SLOT(getDownloadReply(RequestState, QString)));
@@ -46,6 +46,7 @@
 #include <QDir>
 
 #include "filenoderef.h"
+#include "remotedatainterface.h"
 
 Q_DECLARE_LOGGING_CATEGORY(fileManager)
 
@@ -53,14 +54,11 @@ class FileTreeNode;
 class RemoteFileTree;
 class FileMetaData;
 class RemoteFileModel;
-class RemoteDataInterface;
 class FileStandardItem;
 class FileRecursiveOperator;
 
-enum class RequestState;
 enum class NodeState;
 enum class FileOperatorState {IDLE, ACTIVE, UNINITIALIZED};
-enum class RemoteDataInterfaceState;
 
 class FileOperator : public QObject
 {
@@ -90,11 +88,13 @@ public:
     void sendMoveReq(const FileNodeRef &moveFrom, QString newName);
     void sendCopyReq(const FileNodeRef &copyFrom, QString newName);
     void sendRenameReq(const FileNodeRef &selectedNode, QString newName);
+    //Many operations are sent as one batch, which counts as a single file operation
+    void sendBatchReq(QList<RemoteFileOperation> operationList);
 
     void sendCreateFolderReq(const FileNodeRef &selectedNode, QString newName);
 
     void sendUploadReq(const FileNodeRef &uploadTarget, QString localFile);
-    void sendUploadBuffReq(const FileNodeRef &uploadTarget, QByteArray fileBuff, QString newName);
+    void sendUploadBuffReq(const FileNodeRef &uploadTarget, const QByteArray &fileBuff, QString newName);
     void sendDownloadReq(const FileNodeRef &targetFile, QString localDest);
     void sendDownloadBuffReq(const FileNodeRef &targetFile);
 
@@ -106,6 +106,7 @@ signals:
     //Note: it is very important that connections for these signals be queued
     void fileOpStarted();
     void fileOpDone(RequestState opState, QString err_msg);
+    void batchOpProgress(int itemsDone, int itemsFailed, int itemsTotal);
     void fileSystemChange(FileNodeRef changedFile);
 
 protected:
@@ -134,6 +135,7 @@ private slots:
     void getMoveReply(RequestState replyState, FileMetaData revisedFileData, QString from);
     void getCopyReply(RequestState replyState, FileMetaData newFileData);
     void getRenameReply(RequestState replyState, FileMetaData newFileData, QString oldName);
+    void getBatchReply(RequestState replyState, QList<RemoteFileOpResult> itemResults);
 
     void getMkdirReply(RequestState replyState, FileMetaData newFolderData);
 
@@ -182,8 +182,11 @@ void FileTreeNode::setLStask(RemoteDataReply * newTask)
         QObject::disconnect(lsTask, nullptr, this, nullptr);
     }
     lsTask = newTask;
+    lsBatchesVerified = false;
     QObject::connect(lsTask, SIGNAL(haveLSReply(RequestState,QList<FileMetaData>)),
                      this, SLOT(deliverLSdata(RequestState,QList<FileMetaData>)));
+    QObject::connect(lsTask, SIGNAL(haveLSPartialReply(RequestState,QList<FileMetaData>)),
+                     this, SLOT(deliverLSbatch(RequestState,QList<FileMetaData>)));
     recomputeNodeState();
 }
 
@@ -279,6 +282,21 @@ void FileTreeNode::deliverLSdata(RequestState taskState, QList<FileMetaData> dat
     recomputeNodeState();
 }
 
+void FileTreeNode::deliverLSbatch(RequestState, QList<FileMetaData> dataBatch)
+{
+    //Only the first batch has the folder's own entry, which says which node the listing is for
+    if (!getControlAddress(&dataBatch).isEmpty())
+    {
+        lsBatchesVerified = verifyControlNode(&dataBatch);
+    }
+    if (!lsBatchesVerified)
+    {
+        qCDebug(fileManager, "ERROR: File tree data/node mismatch");
+        return;
+    }
+    this->mergeFileNodeData(&dataBatch);
+}
+
 void FileTreeNode::deliverBuffData(RequestState taskState, QByteArray bufferData)
 {
     bufferTask = nullptr;
@@ -635,6 +653,22 @@ void FileTreeNode::updateFileNodeData(QList<FileMetaData> * newDataList)
     recomputeNodeState();
 }
 
+void FileTreeNode::mergeFileNodeData(QList<FileMetaData> * newDataBatch)
+{
+    //A batch is only part of the listing, so nothing is removed until the full listing arrives
+    for (auto itr = newDataBatch->begin(); itr != newDataBatch->end(); itr++)
+    {
+        insertFile(&(*itr));
+    }
+
+    for (auto itr = childList.begin(); itr != childList.end(); itr++)
+    {
+        (*itr)->setNodeVisible();
+    }
+
+    recomputeNodeState();
+}
+
 void FileTreeNode::clearAllChildren()
 {
     while (!childList.isEmpty())
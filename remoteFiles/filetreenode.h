@@ -96,6 +96,7 @@ public:
 
 private slots:
     void deliverLSdata(RequestState taskState, QList<FileMetaData> dataList);
+    void deliverLSbatch(RequestState taskState, QList<FileMetaData> dataBatch);
     void deliverBuffData(RequestState taskState, QByteArray bufferData);
 
 private:
@@ -115,6 +116,7 @@ private:
     bool verifyControlNode(QList<FileMetaData> * newDataList);
     QString getControlAddress(QList<FileMetaData> * newDataList);
     void updateFileNodeData(QList<FileMetaData> * newDataList);
+    void mergeFileNodeData(QList<FileMetaData> * newDataBatch);
 
     void clearAllChildren();
     void insertFile(FileMetaData *newData);
@@ -129,6 +131,7 @@ private:
     QByteArray * fileDataBuffer = nullptr;
 
     RemoteDataReply * lsTask = nullptr;
+    bool lsBatchesVerified = false;
     RemoteDataReply * bufferTask = nullptr;
 
     bool nodeVisible = false;
@@ -40,6 +40,8 @@
 #include "remotejobdata.h"
 #include "joblistnode.h"
 
+#include <QRandomGenerator>
+
 Q_LOGGING_CATEGORY(jobManager, "Job Manager")
 
 JobOperator::JobOperator(RemoteDataInterface * theDataInterface, QObject *parent) : QObject(qobject_cast<QObject *>(parent))
@@ -50,7 +52,7 @@ JobOperator::JobOperator(RemoteDataInterface * theDataInterface, QObject *parent
         qFatal("Cannot create JobOperator object with null remote interface.");
     }
     theJobList.setHorizontalHeaderLabels({"Task Name", "State", "Agave App", "Time Created", "Agave ID"});
-    QObject::connect(myInterface, SIGNAL(connectionStateChanged(RemoteDataInterfaceState)), this, SLOT(interfaceHasNewState(RemoteDataInterfaceState)));
+    QObject::connect(myInterface, SIGNAL(connectionStateChanged(RemoteDataInterfaceState)), this, SLOT(interfaceHasNewState(RemoteDataInterfaceState)), Qt::QueuedConnection);
 
     interfaceHasNewState(myInterface->getInterfaceState());
 }
@@ -92,11 +94,13 @@ void JobOperator::refreshRunningJobList(RequestState replyState, QList<RemoteJob
     {
         qCDebug(jobManager, "Error: unable to list jobs. Bad reply from agave connection.");
         //TODO: Add more error passing
-        QTimer::singleShot(5000, this, SLOT(demandJobDataRefresh()));
+
+        scheduleRetryAfterFailure();
         return;
     }
-
-    bool notDone = false;
+    failedJobRefreshes = 0;
+    lastJobSync = pendingSyncStart;
+    changePollsSinceFullRefresh = 0;
 
     QList<QString> toDel;
     for (auto itr = jobData.begin(); itr != jobData.end(); itr++)
@@ -116,28 +120,98 @@ void JobOperator::refreshRunningJobList(RequestState replyState, QList<RemoteJob
 
     for (auto itr = theData.rbegin(); itr != theData.rend(); itr++)
     {
-        if (jobData.contains((*itr).getID()))
-        {
-            JobListNode * theItem = jobData.value((*itr).getID());
-            theItem->setJobState((*itr).getState());
-        }
-        else
-        {
-            JobListNode * theItem = new JobListNode(*itr, this);
-            jobData.insert(theItem->getData().getID(), theItem);
-        }
-        if (!notDone && (!(*itr).inTerminalState()))
-        {
-            notDone = true;
-        }
+        updateJobNode(*itr);
     }
 
     emit newJobData();
 
-    if (notDone)
+    if (anyJobRunning())
+    {
+        QTimer::singleShot(jobRefreshInterval, this, SLOT(refreshChangedJobs()));
+    }
+}
+
+void JobOperator::refreshChangedJobs()
+{
+    if (currentlyRefreshingJobs())
     {
-        QTimer::singleShot(5000, this, SLOT(demandJobDataRefresh()));
+        return;
     }
+    if (!lastJobSync.isValid() || (changePollsSinceFullRefresh >= changePollsPerFullRefresh))
+    {
+        demandJobDataRefresh();
+        return;
+    }
+
+    pendingSyncStart = QDateTime::currentDateTimeUtc();
+    currentJobRefreshReply = myInterface->getJobListChanges(lastJobSync.addSecs(-jobSyncOverlapSecs));
+    QObject::connect(currentJobRefreshReply, SIGNAL(haveJobList(RequestState,QList<RemoteJobData>)),
+                     this, SLOT(mergeChangedJobs(RequestState,QList<RemoteJobData>)));
+}
+
+void JobOperator::mergeChangedJobs(RequestState replyState, QList<RemoteJobData> theData)
+{
+    //Note: RemoteDataReply destroys itself after signal
+    currentJobRefreshReply = nullptr;
+    if (replyState != RequestState::GOOD)
+    {
+        qCDebug(jobManager, "Error: unable to list changed jobs. Bad reply from agave connection.");
+        scheduleRetryAfterFailure();
+        return;
+    }
+    failedJobRefreshes = 0;
+    lastJobSync = pendingSyncStart;
+    changePollsSinceFullRefresh++;
+
+    //Only changed jobs are listed, so jobs missing here are kept as they are, until the next full refresh
+    for (auto itr = theData.rbegin(); itr != theData.rend(); itr++)
+    {
+        updateJobNode(*itr);
+    }
+
+    if (!theData.isEmpty())
+    {
+        emit newJobData();
+    }
+
+    if (anyJobRunning())
+    {
+        QTimer::singleShot(jobRefreshInterval, this, SLOT(refreshChangedJobs()));
+    }
+}
+
+void JobOperator::updateJobNode(const RemoteJobData &newData)
+{
+    if (jobData.contains(newData.getID()))
+    {
+        JobListNode * theItem = jobData.value(newData.getID());
+        theItem->setJobState(newData.getState());
+    }
+    else
+    {
+        JobListNode * theItem = new JobListNode(newData, this);
+        jobData.insert(theItem->getData().getID(), theItem);
+    }
+}
+
+bool JobOperator::anyJobRunning()
+{
+    for (auto itr = jobData.cbegin(); itr != jobData.cend(); itr++)
+    {
+        if (!(*itr)->getData().inTerminalState())
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void JobOperator::scheduleRetryAfterFailure()
+{
+    //Each failure doubles the wait, and the wait is random, so a struggling server is not hit by every client at once
+    int delayLimit = qMin(jobRefreshInterval << qMin(failedJobRefreshes, 6), maxJobRefreshDelay);
+    failedJobRefreshes++;
+    QTimer::singleShot(delayLimit / 2 + QRandomGenerator::global()->bounded(delayLimit / 2 + 1), this, SLOT(demandJobDataRefresh()));
 }
 
 void JobOperator::jobOperationFollowup(RequestState replyState)
@@ -243,6 +317,7 @@ void JobOperator::demandJobDataRefresh()
     {
         return;
     }
+    pendingSyncStart = QDateTime::currentDateTimeUtc();
     currentJobRefreshReply = myInterface->getListOfJobs();
     QObject::connect(currentJobRefreshReply, SIGNAL(haveJobList(RequestState,QList<RemoteJobData>)),
                      this, SLOT(refreshRunningJobList(RequestState,QList<RemoteJobData>)));
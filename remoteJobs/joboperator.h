@@ -42,6 +42,7 @@
 #include <QMap>
 #include <QStandardItemModel>
 #include <QTimer>
+#include <QDateTime>
 #include <QLoggingCategory>
 
 class RemoteFileWindow;
@@ -93,11 +94,16 @@ protected:
 
 private slots:
     void refreshRunningJobList(RequestState replyState, QList<RemoteJobData> theData);
+    void refreshChangedJobs();
+    void mergeChangedJobs(RequestState replyState, QList<RemoteJobData> theData);
     void jobOperationFollowup(RequestState replyState);
 
 private:
     static bool listHasJobId(QList<RemoteJobData> theData, QString toFind);
     JobListNode * getRealNode(const RemoteJobData *toFetch);
+    void updateJobNode(const RemoteJobData &newData);
+    bool anyJobRunning();
+    void scheduleRetryAfterFailure();
 
     RemoteDataInterface * myInterface;
 
@@ -105,6 +111,20 @@ private:
     RemoteDataReply * currentJobRefreshReply = nullptr;
     RemoteDataReply * currentJobOpReply = nullptr;
 
+    const int jobRefreshInterval = 5000;
+    const int maxJobRefreshDelay = 5 * 60 * 1000;
+    int failedJobRefreshes = 0;
+
+    //Polls between full refreshes only ask for jobs changed since the last sync.
+    //The window overlaps a little, so clock skew with the server does not lose changes.
+    QDateTime lastJobSync;
+    QDateTime pendingSyncStart;
+    const int jobSyncOverlapSecs = 60;
+
+    //Jobs deleted or hidden elsewhere are never listed as changed, so every so often the full list is read again
+    const int changePollsPerFullRefresh = 12;
+    int changePollsSinceFullRefresh = 0;
+
     QStandardItemModel theJobList;
 
     QList<RemoteJobLister *> linkedListerWidgets;
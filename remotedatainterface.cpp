@@ -38,7 +38,21 @@
 Q_LOGGING_CATEGORY(remoteInterface, "Remote Interface")
 Q_LOGGING_CATEGORY(rawHTTP, "Raw HTTP")
 
-RemoteDataInterface::RemoteDataInterface(QObject *parent):QObject(parent) {}
+RemoteDataInterface::RemoteDataInterface(QObject *parent):QObject(parent)
+{
+    //Needed for queued connections, when replies are sent from another thread
+    qRegisterMetaType<RemoteDataInterfaceState>("RemoteDataInterfaceState");
+    qRegisterMetaType<RequestState>("RequestState");
+    qRegisterMetaType<FileMetaData>("FileMetaData");
+    qRegisterMetaType<QList<FileMetaData>>("QList<FileMetaData>");
+    qRegisterMetaType<RemoteJobData>("RemoteJobData");
+    qRegisterMetaType<QList<RemoteJobData>>("QList<RemoteJobData>");
+    qRegisterMetaType<ParamMap>("ParamMap");
+    qRegisterMetaType<RemoteFileOperation>("RemoteFileOperation");
+    qRegisterMetaType<QList<RemoteFileOperation>>("QList<RemoteFileOperation>");
+    qRegisterMetaType<RemoteFileOpResult>("RemoteFileOpResult");
+    qRegisterMetaType<QList<RemoteFileOpResult>>("QList<RemoteFileOpResult>");
+}
 
 QString RemoteDataInterface::interpretRequestState(RequestState theState)
 {
@@ -94,6 +108,8 @@ QString RemoteDataInterface::interpretRequestState(RequestState theState)
         return "An unclassified error occured";
     case RequestState::STOPPED_BY_USER:
         return "Task stopped by user";
+    case RequestState::REQUEST_TIMEOUT:
+        return "Task did not finish in the time allowed";
     }
     return "INTERNAL ERROR";
 }
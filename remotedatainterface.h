@@ -75,11 +75,38 @@ enum class RequestState {GOOD, PENDING,
                          GENERIC_NETWORK_ERROR, REMOTE_SERVER_ERROR,
                          LOCAL_FILE_ERROR, JSON_PARSE_ERROR,
                          EXPLICIT_ERROR, MISSING_REPLY_STATUS,
-                         MISSING_REPLY_DATA, STOPPED_BY_USER,
+                         MISSING_REPLY_DATA, STOPPED_BY_USER, REQUEST_TIMEOUT,
                          INVALID_PARAM, NOT_READY,
                          NOT_IMPLEMENTED, UNCLASSIFIED};
 //If RemoteDataReply returned is nullptr, then the request was invalid due to internal error
 
+//Reply and state signals may cross threads, if the interface runs on its own thread, so their types are registered
+Q_DECLARE_METATYPE(RemoteDataInterfaceState)
+Q_DECLARE_METATYPE(RequestState)
+
+enum class FileOperationType {REMOVE, MOVE, COPY, RENAME};
+
+//One item of a batch of file operations. The target is the destination of a move or copy, or the new name of a rename.
+class RemoteFileOperation
+{
+public:
+    FileOperationType opType = FileOperationType::REMOVE;
+    QString remotePath;
+    QString target;
+};
+
+//The outcome of one item of a batch. A move, copy or rename also gives the resulting file.
+class RemoteFileOpResult
+{
+public:
+    RemoteFileOperation theOperation;
+    RequestState resultState = RequestState::PENDING;
+    FileMetaData newFileData;
+};
+
+Q_DECLARE_METATYPE(RemoteFileOperation)
+Q_DECLARE_METATYPE(RemoteFileOpResult)
+
 class RemoteDataReply : public QObject
 {
     Q_OBJECT
@@ -88,18 +115,32 @@ public:
     RemoteDataReply(QObject * parent);
     virtual void setAsUnconnectedReply() = 0;
 
+public slots:
+    //Stops the request, which then gives its usual reply signal with STOPPED_BY_USER
+    virtual void cancel() = 0;
+    //If the request is not done this many milliseconds from now, it is stopped, and gives REQUEST_TIMEOUT.
+    //Without this, each request to the server has the default deadline of its task, if any. Zero or less removes the deadline.
+    virtual void setDeadline(int deadlineMillis) = 0;
+
 signals:
     //All referenced values should be copied by the reciever or they will be discarded
     void startedLogout(RequestState replyState);
 
     void haveAuthReply(RequestState authReply);
     void haveLSReply(RequestState replyState, QList<FileMetaData> fileDataList);
+    //Large listings also give their entries in batches as they arrive, with the PENDING state, before the full haveLSReply
+    void haveLSPartialReply(RequestState replyState, QList<FileMetaData> fileDataBatch);
 
     void haveDeleteReply(RequestState replyState, QString toDelete);
     void haveMoveReply(RequestState replyState, FileMetaData revisedFileData, QString from);
     void haveCopyReply(RequestState replyState, FileMetaData newFileData);
     void haveRenameReply(RequestState replyState, FileMetaData newFileData, QString oldName);
 
+    //A batch gives its progress as each item finishes, then the results of all items, in the order given.
+    //The batch state is GOOD only if every item succeeded.
+    void haveBatchProgress(int itemsDone, int itemsFailed, int itemsTotal);
+    void haveBatchReply(RequestState replyState, QList<RemoteFileOpResult> itemResults);
+
     void haveMkdirReply(RequestState replyState, FileMetaData newFolderData);
 
     void haveUploadReply(RequestState replyState, FileMetaData newFileData);
@@ -154,17 +195,24 @@ public slots:
     virtual RemoteDataReply * moveFile(QString from, QString to) = 0;
     virtual RemoteDataReply * copyFile(QString from, QString to) = 0;
     virtual RemoteDataReply * renameFile(QString fullName, QString newName) = 0;
+    //Performs many file operations, several at once, with one reply for all of them
+    virtual RemoteDataReply * batchFileOperations(QList<RemoteFileOperation> operationList) = 0;
 
     virtual RemoteDataReply * mkRemoteDir(QString location, QString newName) = 0;
 
     virtual RemoteDataReply * uploadFile(QString location, QString localFileName) = 0;
-    virtual RemoteDataReply * uploadBuffer(QString location, QByteArray fileData, QString newFileName) = 0;
-    virtual RemoteDataReply * downloadFile(QString localDest, QString remoteName) = 0;
+    //The data is shared with the upload, not copied, so the caller may release its own copy right away
+    virtual RemoteDataReply * uploadBuffer(QString location, const QByteArray &fileData, QString newFileName) = 0;
+    //If the size of the remote file is known, large files may be fetched in parallel segments
+    virtual RemoteDataReply * downloadFile(QString localDest, QString remoteName, qint64 remoteSize = -1) = 0;
+    //A download interrupted by a lost connection continues from where it stopped when requested again
     virtual RemoteDataReply * downloadBuffer(QString remoteName) = 0;
 
     virtual RemoteDataReply * runRemoteJob(QString jobName, ParamMap jobParameters, QString remoteWorkingDir, QString indivJobName = "", QString archivePath = "") = 0;
 
     virtual RemoteDataReply * getListOfJobs() = 0;
+    //Gives only the jobs changed after the given time, so that a job list can be kept up to date cheaply
+    virtual RemoteDataReply * getJobListChanges(QDateTime changedSince) = 0;
     virtual RemoteDataReply * getJobDetails(QString IDstr) = 0;
     virtual RemoteDataReply * stopJob(QString IDstr) = 0;
     virtual RemoteDataReply * deleteJob(QString IDstr) = 0;
@@ -39,6 +39,7 @@
 
 #include <QDateTime>
 #include <QMap>
+#include <QMetaType>
 
 class RemoteJobData
 {
@@ -79,4 +80,6 @@ private:
     bool jobEntryValid = false;
 };
 
+Q_DECLARE_METATYPE(RemoteJobData)
+
 #endif // REMOTEJOBDATA_H
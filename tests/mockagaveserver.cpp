@@ -0,0 +1,368 @@
+/*********************************************************************************
+**
+** Copyright (c) 2017 The University of Notre Dame
+** Copyright (c) 2017 The Regents of the University of California
+**
+** Redistribution and use in source and binary forms, with or without modification,
+** are permitted provided that the following conditions are met:
+**
+** 1. Redistributions of source code must retain the above copyright notice, this
+** list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright notice, this
+** list of conditions and the following disclaimer in the documentation and/or other
+** materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its contributors may
+** be used to endorse or promote products derived from this software without specific
+** prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+** EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+** SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+** TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+** BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+** CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+** IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+** SUCH DAMAGE.
+**
+***********************************************************************************/
+
+// Contributors:
+// Written by Peter Sempolinski, for the Natural Hazard Modeling Laboratory, director: Ahsan Kareem, at Notre Dame
+
+#include "mockagaveserver.h"
+
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRegularExpression>
+#include <QUrl>
+
+MockAgaveServer::MockAgaveServer(QObject * parent) : QObject(parent)
+{
+    QObject::connect(&listener, SIGNAL(newConnection()), this, SLOT(newClient()));
+}
+
+bool MockAgaveServer::start()
+{
+    return listener.listen(QHostAddress::LocalHost);
+}
+
+QString MockAgaveServer::getTenantURL()
+{
+    return QString("http://127.0.0.1:%1").arg(listener.serverPort());
+}
+
+void MockAgaveServer::setAssembleParts(bool assemble)
+{
+    assembleParts = assemble;
+}
+
+void MockAgaveServer::setFailingPartStart(qint64 partStart)
+{
+    failingPartStart = partStart;
+}
+
+void MockAgaveServer::addStoredFile(QString remotePath, QByteArray fileData)
+{
+    storedFiles.insert(remotePath, fileData);
+}
+
+QByteArray MockAgaveServer::getStoredFile(QString remotePath)
+{
+    return storedFiles.value(remotePath);
+}
+
+QList<MockRequest> MockAgaveServer::getUploadLog()
+{
+    return uploadLog;
+}
+
+void MockAgaveServer::clearUploadLog()
+{
+    uploadLog.clear();
+}
+
+QList<MockRequest> MockAgaveServer::getRequestLog()
+{
+    return requestLog;
+}
+
+void MockAgaveServer::clearRequestLog()
+{
+    requestLog.clear();
+}
+
+void MockAgaveServer::newClient()
+{
+    while (listener.hasPendingConnections())
+    {
+        QTcpSocket * client = listener.nextPendingConnection();
+        pendingData.insert(client, QByteArray());
+        QObject::connect(client, SIGNAL(readyRead()), this, SLOT(readClient()));
+        QObject::connect(client, SIGNAL(disconnected()), this, SLOT(dropClient()));
+    }
+}
+
+void MockAgaveServer::dropClient()
+{
+    QTcpSocket * client = qobject_cast<QTcpSocket *>(sender());
+    if (client == nullptr) return;
+    pendingData.remove(client);
+    client->deleteLater();
+}
+
+void MockAgaveServer::readClient()
+{
+    QTcpSocket * client = qobject_cast<QTcpSocket *>(sender());
+    if (client == nullptr) return;
+
+    QByteArray &buffer = pendingData[client];
+    buffer.append(client->readAll());
+
+    //A kept-alive connection may carry several requests, one after another
+    while (true)
+    {
+        int headEnd = buffer.indexOf("\r\n\r\n");
+        if (headEnd < 0) return;
+
+        QList<QByteArray> headLines = buffer.left(headEnd).split('\n');
+        QList<QByteArray> requestLine = headLines.takeFirst().trimmed().split(' ');
+        if (requestLine.size() < 2)
+        {
+            client->abort();
+            return;
+        }
+
+        MockRequest request;
+        request.method = requestLine.at(0);
+        request.path = requestLine.at(1);
+        for (const QByteArray &aLine : headLines)
+        {
+            int colon = aLine.indexOf(':');
+            if (colon < 0) continue;
+            request.headers.insert(aLine.left(colon).trimmed().toLower(), aLine.mid(colon + 1).trimmed());
+        }
+
+        int bodySize = request.headers.value("content-length").toInt();
+        if (buffer.size() < headEnd + 4 + bodySize) return;
+
+        request.body = buffer.mid(headEnd + 4, bodySize);
+        buffer.remove(0, headEnd + 4 + bodySize);
+
+        answerRequest(client, request);
+    }
+}
+
+void MockAgaveServer::answerRequest(QTcpSocket * client, const MockRequest &request)
+{
+    requestLog.append(request);
+
+    QByteArray path = request.path;
+    int queryStart = path.indexOf('?');
+    if (queryStart >= 0) path.truncate(queryStart);
+
+    if (path.startsWith("/clients/v2"))
+    {
+        QJsonObject result;
+        if (request.method == "POST")
+        {
+            result.insert("consumerKey", "mockClientKey");
+            result.insert("consumerSecret", "mockClientSecret");
+        }
+        QJsonObject replyObject;
+        replyObject.insert("status", "success");
+        replyObject.insert("result", result);
+        sendReply(client, 200, QJsonDocument(replyObject).toJson(QJsonDocument::Compact));
+    }
+    else if (path == "/token")
+    {
+        QJsonObject replyObject;
+        replyObject.insert("access_token", "mockAccessToken");
+        replyObject.insert("refresh_token", "mockRefreshToken");
+        replyObject.insert("expires_in", 14400);
+        sendReply(client, 200, QJsonDocument(replyObject).toJson(QJsonDocument::Compact));
+    }
+    else if (path.startsWith("/files/v2/media/system/") && (request.method == "POST"))
+    {
+        answerUpload(client, request);
+    }
+    else if (path.startsWith("/files/v2/listings/system/") && (request.method == "GET"))
+    {
+        answerListing(client, request);
+    }
+    else if (path.startsWith("/files/v2/media/system/") && (request.method == "PUT"))
+    {
+        answerFileAction(client, request);
+    }
+    else
+    {
+        sendReply(client, 404, "{\"status\":\"error\",\"message\":\"Not found\"}");
+    }
+}
+
+void MockAgaveServer::answerUpload(QTcpSocket * client, const MockRequest &request)
+{
+    uploadLog.append(request);
+
+    //The path is /files/v2/media/system/<storage>/<destination folder>
+    QByteArray folderPart = request.path.mid(QByteArray("/files/v2/media/system/").size());
+    folderPart = folderPart.mid(folderPart.indexOf('/'));
+    QString remoteFolder = QUrl::fromPercentEncoding(folderPart);
+    while (remoteFolder.endsWith('/')) remoteFolder.chop(1);
+
+    //The body is a multipart form, with the file as its one part
+    QByteArray contentType = request.headers.value("content-type");
+    QByteArray boundary = contentType.mid(contentType.indexOf("boundary=") + 9);
+    if (boundary.startsWith('"')) boundary = boundary.mid(1, boundary.lastIndexOf('"') - 1);
+    QByteArray delimiter = "--" + boundary;
+
+    int partBegin = request.body.indexOf(delimiter);
+    int partHeadEnd = request.body.indexOf("\r\n\r\n", partBegin);
+    int partDataEnd = request.body.indexOf("\r\n" + delimiter, partHeadEnd);
+    if ((partBegin < 0) || (partHeadEnd < 0) || (partDataEnd < 0))
+    {
+        sendReply(client, 400, "{\"status\":\"error\",\"message\":\"Bad upload form\"}");
+        return;
+    }
+
+    QString partHead = QString::fromUtf8(request.body.mid(partBegin, partHeadEnd - partBegin));
+    QByteArray fileData = request.body.mid(partHeadEnd + 4, partDataEnd - partHeadEnd - 4);
+
+    QRegularExpressionMatch nameMatch = QRegularExpression("filename=\"([^\"]*)\"").match(partHead);
+    QString fileName = nameMatch.captured(1);
+    fileName = fileName.mid(fileName.lastIndexOf('/') + 1);
+    QString remotePath = remoteFolder + "/" + fileName;
+
+    QMap<QByteArray, QByteArray> extraHeaders;
+    QByteArray contentRange = request.headers.value("content-range");
+
+    if (contentRange.isEmpty() || !assembleParts)
+    {
+        storedFiles.insert(remotePath, fileData);
+    }
+    else
+    {
+        //Content-Range is of the form: bytes first-last/total
+        qint64 rangeBegin = contentRange.mid(6, contentRange.indexOf('-') - 6).trimmed().toLongLong();
+        if (rangeBegin == failingPartStart)
+        {
+            sendReply(client, 404, "{\"status\":\"error\",\"message\":\"Part refused\"}");
+            return;
+        }
+
+        QByteArray heldData = (rangeBegin == 0) ? QByteArray() : storedFiles.value(remotePath);
+        if (rangeBegin != heldData.size())
+        {
+            sendReply(client, 416, "{\"status\":\"error\",\"message\":\"Part out of order\"}");
+            return;
+        }
+        heldData.append(fileData);
+        storedFiles.insert(remotePath, heldData);
+        extraHeaders.insert("Range", "bytes=0-" + QByteArray::number(heldData.size() - 1));
+    }
+
+    QJsonObject fileObject;
+    fileObject.insert("name", fileName);
+    fileObject.insert("path", remotePath);
+    fileObject.insert("nativeFormat", "raw");
+    fileObject.insert("type", "file");
+    fileObject.insert("length", static_cast<double>(storedFiles.value(remotePath).size()));
+
+    QJsonObject replyObject;
+    replyObject.insert("status", "success");
+    replyObject.insert("result", fileObject);
+    sendReply(client, 202, QJsonDocument(replyObject).toJson(QJsonDocument::Compact), extraHeaders);
+}
+
+void MockAgaveServer::answerListing(QTcpSocket * client, const MockRequest &request)
+{
+    //The path is /files/v2/listings/system/<storage>/<folder>, maybe with a query after it
+    QByteArray folderPart = request.path.mid(QByteArray("/files/v2/listings/system/").size());
+    if (folderPart.contains('?')) folderPart.truncate(folderPart.indexOf('?'));
+    folderPart = folderPart.mid(folderPart.indexOf('/'));
+    QString remoteFolder = QUrl::fromPercentEncoding(folderPart);
+    while (remoteFolder.endsWith('/')) remoteFolder.chop(1);
+
+    //As from Agave, the folder itself comes first, named "."
+    QJsonArray entryList;
+    QJsonObject folderObject;
+    folderObject.insert("name", ".");
+    folderObject.insert("path", remoteFolder);
+    folderObject.insert("format", "folder");
+    folderObject.insert("type", "dir");
+    folderObject.insert("length", 0);
+    entryList.append(folderObject);
+
+    for (auto itr = storedFiles.cbegin(); itr != storedFiles.cend(); itr++)
+    {
+        int nameStart = itr.key().lastIndexOf('/');
+        if (itr.key().left(nameStart) != remoteFolder) continue;
+
+        QJsonObject fileObject;
+        fileObject.insert("name", itr.key().mid(nameStart + 1));
+        fileObject.insert("path", itr.key());
+        fileObject.insert("format", "raw");
+        fileObject.insert("type", "file");
+        fileObject.insert("length", static_cast<double>(itr->size()));
+        entryList.append(fileObject);
+    }
+
+    QJsonObject replyObject;
+    replyObject.insert("status", "success");
+    replyObject.insert("result", entryList);
+    sendReply(client, 200, QJsonDocument(replyObject).toJson(QJsonDocument::Compact));
+}
+
+void MockAgaveServer::answerFileAction(QTcpSocket * client, const MockRequest &request)
+{
+    //The path is /files/v2/media/system/<storage>/<folder>, and the body a form, such as action=mkdir&path=<name>
+    QByteArray folderPart = request.path.mid(QByteArray("/files/v2/media/system/").size());
+    folderPart = folderPart.mid(folderPart.indexOf('/'));
+    QString remoteFolder = QUrl::fromPercentEncoding(folderPart);
+    while (remoteFolder.endsWith('/')) remoteFolder.chop(1);
+
+    QMap<QString, QString> formValues;
+    for (const QByteArray &aPair : request.body.split('&'))
+    {
+        int equals = aPair.indexOf('=');
+        if (equals < 0) continue;
+        formValues.insert(QUrl::fromPercentEncoding(aPair.left(equals)), QUrl::fromPercentEncoding(aPair.mid(equals + 1)));
+    }
+
+    if (formValues.value("action") != "mkdir")
+    {
+        sendReply(client, 400, "{\"status\":\"error\",\"message\":\"Unknown action\"}");
+        return;
+    }
+
+    QJsonObject folderObject;
+    folderObject.insert("name", formValues.value("path"));
+    folderObject.insert("path", remoteFolder + "/" + formValues.value("path"));
+    folderObject.insert("nativeFormat", "dir");
+    folderObject.insert("type", "dir");
+
+    QJsonObject replyObject;
+    replyObject.insert("status", "success");
+    replyObject.insert("result", folderObject);
+    sendReply(client, 201, QJsonDocument(replyObject).toJson(QJsonDocument::Compact));
+}
+
+void MockAgaveServer::sendReply(QTcpSocket * client, int httpStatus, const QByteArray &replyText,
+                                QMap<QByteArray, QByteArray> extraHeaders)
+{
+    QByteArray replyHead = "HTTP/1.1 " + QByteArray::number(httpStatus) + " Mock\r\n";
+    replyHead.append("Content-Type: application/json\r\n");
+    replyHead.append("Content-Length: " + QByteArray::number(replyText.size()) + "\r\n");
+    for (auto itr = extraHeaders.cbegin(); itr != extraHeaders.cend(); itr++)
+    {
+        replyHead.append(itr.key() + ": " + *itr + "\r\n");
+    }
+    replyHead.append("\r\n");
+
+    client->write(replyHead);
+    client->write(replyText);
+}
@@ -0,0 +1,107 @@
+/*********************************************************************************
+**
+** Copyright (c) 2017 The University of Notre Dame
+** Copyright (c) 2017 The Regents of the University of California
+**
+** Redistribution and use in source and binary forms, with or without modification,
+** are permitted provided that the following conditions are met:
+**
+** 1. Redistributions of source code must retain the above copyright notice, this
+** list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright notice, this
+** list of conditions and the following disclaimer in the documentation and/or other
+** materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its contributors may
+** be used to endorse or promote products derived from this software without specific
+** prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+** EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+** SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+** TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+** BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+** CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+** IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+** SUCH DAMAGE.
+**
+***********************************************************************************/
+
+// Contributors:
+// Written by Peter Sempolinski, for the Natural Hazard Modeling Laboratory, director: Ahsan Kareem, at Notre Dame
+
+#ifndef MOCKAGAVESERVER_H
+#define MOCKAGAVESERVER_H
+
+#include <QObject>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QHash>
+#include <QMap>
+#include <QList>
+#include <QByteArray>
+#include <QString>
+
+class MockRequest
+{
+public:
+    QByteArray method;
+    QByteArray path;
+    //Header names are kept in lower case
+    QMap<QByteArray, QByteArray> headers;
+    QByteArray body;
+};
+
+//A small local HTTP server which answers as an Agave tenant does for login, listings, new folders and file uploads.
+//An upload with a Content-Range header is added to the file, if parts are assembled, and acknowledged
+//with a "Range: bytes=0-last" header. Otherwise every upload replaces the file, as Agave v2 does.
+class MockAgaveServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit MockAgaveServer(QObject * parent = nullptr);
+
+    bool start();
+    QString getTenantURL();
+
+    void setAssembleParts(bool assemble);
+    //An upload part beginning at this byte is refused, until set to -1
+    void setFailingPartStart(qint64 partStart);
+
+    void addStoredFile(QString remotePath, QByteArray fileData);
+    QByteArray getStoredFile(QString remotePath);
+    QList<MockRequest> getUploadLog();
+    void clearUploadLog();
+    //Every request, in the order they arrived
+    QList<MockRequest> getRequestLog();
+    void clearRequestLog();
+
+private slots:
+    void newClient();
+    void readClient();
+    void dropClient();
+
+private:
+    void answerRequest(QTcpSocket * client, const MockRequest &request);
+    void answerUpload(QTcpSocket * client, const MockRequest &request);
+    void answerListing(QTcpSocket * client, const MockRequest &request);
+    void answerFileAction(QTcpSocket * client, const MockRequest &request);
+    void sendReply(QTcpSocket * client, int httpStatus, const QByteArray &replyText,
+                   QMap<QByteArray, QByteArray> extraHeaders = QMap<QByteArray, QByteArray>());
+
+    QTcpServer listener;
+    QHash<QTcpSocket *, QByteArray> pendingData;
+
+    bool assembleParts = true;
+    qint64 failingPartStart = -1;
+
+    QMap<QString, QByteArray> storedFiles;
+    QList<MockRequest> uploadLog;
+    QList<MockRequest> requestLog;
+};
+
+#endif // MOCKAGAVESERVER_H
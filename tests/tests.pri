@@ -0,0 +1,15 @@
+#Each test builds the library in, with a local mock server to talk to. Run them all with: make check
+
+QT += core network widgets testlib
+CONFIG += testcase console
+CONFIG -= app_bundle
+
+include($$PWD/../AgaveClientInterface.pri)
+
+INCLUDEPATH += "$$PWD/"
+
+SOURCES += \
+    $$PWD/mockagaveserver.cpp
+
+HEADERS += \
+    $$PWD/mockagaveserver.h
@@ -0,0 +1,7 @@
+TEMPLATE = subdirs
+
+SUBDIRS += \
+    tst_chunkedupload \
+    tst_listingparser \
+    tst_requestencoding \
+    tst_threading
@@ -0,0 +1,192 @@
+/*********************************************************************************
+**
+** Copyright (c) 2017 The University of Notre Dame
+** Copyright (c) 2017 The Regents of the University of California
+**
+** Redistribution and use in source and binary forms, with or without modification,
+** are permitted provided that the following conditions are met:
+**
+** 1. Redistributions of source code must retain the above copyright notice, this
+** list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright notice, this
+** list of conditions and the following disclaimer in the documentation and/or other
+** materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its contributors may
+** be used to endorse or promote products derived from this software without specific
+** prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+** EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+** SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+** TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+** BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+** CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+** IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+** SUCH DAMAGE.
+**
+***********************************************************************************/
+
+// Contributors:
+// Written by Peter Sempolinski, for the Natural Hazard Modeling Laboratory, director: Ahsan Kareem, at Notre Dame
+
+#include "mockagaveserver.h"
+#include "agaveInterfaces/agavehandler.h"
+
+#include <QtTest>
+#include <QNetworkAccessManager>
+#include <QTemporaryDir>
+
+class TestChunkedUpload : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void uploadsInAssembledParts();
+    void resumesFromLastAcknowledgedPart();
+    void uploadsWholeWithoutAcknowledgement();
+
+private:
+    QString makeLocalFile(QString fileName, int byteCount);
+    RequestState waitForUpload(RemoteDataReply * uploadReply, FileMetaData * newFileData = nullptr);
+
+    const qint64 partSize = 1000;
+    const int fileSize = 3500;
+
+    MockAgaveServer * mockServer = nullptr;
+    QNetworkAccessManager * netManager = nullptr;
+    AgaveHandler * theHandler = nullptr;
+    QTemporaryDir * localDir = nullptr;
+};
+
+void TestChunkedUpload::init()
+{
+    localDir = new QTemporaryDir();
+    QVERIFY(localDir->isValid());
+
+    mockServer = new MockAgaveServer();
+    QVERIFY(mockServer->start());
+
+    netManager = new QNetworkAccessManager();
+    theHandler = new AgaveHandler(netManager);
+    theHandler->setAgaveConnectionParams(mockServer->getTenantURL(), "testClient", "mockStorage");
+    theHandler->setChunkedUploadParams(0, partSize);
+
+    RemoteDataReply * authReply = theHandler->performAuth("testUser", "testPass");
+    QVERIFY(authReply != nullptr);
+    QSignalSpy authSpy(authReply, SIGNAL(haveAuthReply(RequestState)));
+    QVERIFY(authSpy.wait(5000));
+    QCOMPARE(authSpy.at(0).at(0).value<RequestState>(), RequestState::GOOD);
+}
+
+void TestChunkedUpload::cleanup()
+{
+    delete theHandler;
+    delete netManager;
+    delete mockServer;
+    delete localDir;
+}
+
+void TestChunkedUpload::uploadsInAssembledParts()
+{
+    QString localFile = makeLocalFile("assembled.dat", fileSize);
+
+    FileMetaData newFileData;
+    QCOMPARE(waitForUpload(theHandler->uploadFile("/testUser/uploads", localFile), &newFileData), RequestState::GOOD);
+
+    QList<MockRequest> uploadLog = mockServer->getUploadLog();
+    QCOMPARE(uploadLog.size(), 4);
+    QCOMPARE(uploadLog.at(0).headers.value("content-range"), QByteArray("bytes 0-999/3500"));
+    QCOMPARE(uploadLog.at(3).headers.value("content-range"), QByteArray("bytes 3000-3499/3500"));
+
+    QFile sentFile(localFile);
+    QVERIFY(sentFile.open(QIODevice::ReadOnly));
+    QCOMPARE(mockServer->getStoredFile("/testUser/uploads/assembled.dat"), sentFile.readAll());
+    QCOMPARE(newFileData.getSize(), static_cast<qint64>(fileSize));
+    QVERIFY(!QFile::exists(localFile + ".upload.info"));
+}
+
+void TestChunkedUpload::resumesFromLastAcknowledgedPart()
+{
+    QString localFile = makeLocalFile("resumed.dat", fileSize);
+
+    //The third part is refused, after the first two are acknowledged
+    mockServer->setFailingPartStart(2000);
+    QVERIFY(waitForUpload(theHandler->uploadFile("/testUser/uploads", localFile)) != RequestState::GOOD);
+    QCOMPARE(mockServer->getUploadLog().size(), 3);
+    QVERIFY(QFile::exists(localFile + ".upload.info"));
+
+    mockServer->setFailingPartStart(-1);
+    mockServer->clearUploadLog();
+    QCOMPARE(waitForUpload(theHandler->uploadFile("/testUser/uploads", localFile)), RequestState::GOOD);
+
+    //Only the parts not acknowledged before are sent again
+    QList<MockRequest> uploadLog = mockServer->getUploadLog();
+    QCOMPARE(uploadLog.size(), 2);
+    QCOMPARE(uploadLog.at(0).headers.value("content-range"), QByteArray("bytes 2000-2999/3500"));
+
+    QFile sentFile(localFile);
+    QVERIFY(sentFile.open(QIODevice::ReadOnly));
+    QCOMPARE(mockServer->getStoredFile("/testUser/uploads/resumed.dat"), sentFile.readAll());
+    QVERIFY(!QFile::exists(localFile + ".upload.info"));
+}
+
+void TestChunkedUpload::uploadsWholeWithoutAcknowledgement()
+{
+    //Like Agave v2, this server stores each part as the whole file, and does not acknowledge it
+    mockServer->setAssembleParts(false);
+    QString localFile = makeLocalFile("whole.dat", fileSize);
+
+    QCOMPARE(waitForUpload(theHandler->uploadFile("/testUser/uploads", localFile)), RequestState::GOOD);
+
+    QList<MockRequest> uploadLog = mockServer->getUploadLog();
+    QCOMPARE(uploadLog.size(), 2);
+    QVERIFY(uploadLog.at(0).headers.contains("content-range"));
+    QVERIFY(!uploadLog.at(1).headers.contains("content-range"));
+
+    QFile sentFile(localFile);
+    QVERIFY(sentFile.open(QIODevice::ReadOnly));
+    QCOMPARE(mockServer->getStoredFile("/testUser/uploads/whole.dat"), sentFile.readAll());
+
+    //Later uploads do not try parts again
+    mockServer->clearUploadLog();
+    QCOMPARE(waitForUpload(theHandler->uploadFile("/testUser/uploads", localFile)), RequestState::GOOD);
+    QCOMPARE(mockServer->getUploadLog().size(), 1);
+    QVERIFY(!mockServer->getUploadLog().at(0).headers.contains("content-range"));
+}
+
+QString TestChunkedUpload::makeLocalFile(QString fileName, int byteCount)
+{
+    QByteArray fileData;
+    for (int i = 0; i < byteCount; i++)
+    {
+        fileData.append(static_cast<char>('a' + ((i * 7) % 26)));
+    }
+
+    QString fullName = localDir->filePath(fileName);
+    QFile localFile(fullName);
+    if (!localFile.open(QIODevice::WriteOnly)) return QString();
+    localFile.write(fileData);
+    localFile.close();
+    return fullName;
+}
+
+RequestState TestChunkedUpload::waitForUpload(RemoteDataReply * uploadReply, FileMetaData * newFileData)
+{
+    if (uploadReply == nullptr) return RequestState::INTERNAL_ERROR;
+
+    QSignalSpy uploadSpy(uploadReply, SIGNAL(haveUploadReply(RequestState,FileMetaData)));
+    if (!uploadSpy.wait(10000)) return RequestState::PENDING;
+
+    if (newFileData != nullptr) *newFileData = uploadSpy.at(0).at(1).value<FileMetaData>();
+    return uploadSpy.at(0).at(0).value<RequestState>();
+}
+
+QTEST_MAIN(TestChunkedUpload)
+#include "tst_chunkedupload.moc"
@@ -0,0 +1,6 @@
+TARGET = tst_chunkedupload
+
+include(../tests.pri)
+
+SOURCES += \
+    tst_chunkedupload.cpp
@@ -0,0 +1,178 @@
+/*********************************************************************************
+**
+** Copyright (c) 2017 The University of Notre Dame
+** Copyright (c) 2017 The Regents of the University of California
+**
+** Redistribution and use in source and binary forms, with or without modification,
+** are permitted provided that the following conditions are met:
+**
+** 1. Redistributions of source code must retain the above copyright notice, this
+** list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright notice, this
+** list of conditions and the following disclaimer in the documentation and/or other
+** materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its contributors may
+** be used to endorse or promote products derived from this software without specific
+** prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+** EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+** SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+** TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+** BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+** CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+** IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+** SUCH DAMAGE.
+**
+***********************************************************************************/
+
+// Contributors:
+
+#include "agaveInterfaces/agavelistingparser.h"
+
+#include <QtTest>
+
+//The listing parser reads a reply as it arrives, so each reply is fed split at every byte,
+//and one byte at a time, and must give the same entries and final state every way
+class TestListingParser : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void splitAtEveryByte_data();
+    void splitAtEveryByte();
+    void oneByteAtATime_data();
+    void oneByteAtATime();
+
+private:
+    void addListingRows();
+    RequestState feedListing(const QList<QByteArray> &pieces, QStringList * entryNames);
+};
+
+void TestListingParser::addListingRows()
+{
+    QTest::addColumn<QByteArray>("replyText");
+    QTest::addColumn<RequestState>("expectedState");
+    QTest::addColumn<QStringList>("expectedNames");
+
+    //Names with escaped quotes and backslashes, one ending in a backslash, and brackets and commas inside strings
+    QByteArray oddNames = R"JSON({"status":"success","message":null,"version":"2.2.0","result":[
+        {"name":".","path":"/u/dir","type":"dir","format":"folder","length":0},
+        {"name":"quote\"d.txt","path":"/u/dir/quote\"d.txt","type":"file","format":"raw","length":3},
+        {"name":"back\\slash","path":"/u/dir/back\\slash","type":"file","format":"raw","length":4},
+        {"name":"end\\","path":"/u/dir/end\\","type":"file","format":"raw","length":5},
+        {"name":"br}ace]s, [and {","path":"/u/dir/br}ace]s, [and {","type":"file","format":"raw","length":6},
+        {"name":"ümläut","path":"/u/dir/ümläut","type":"dir","format":"folder","length":0}
+    ]})JSON";
+    QTest::newRow("escaped names") << oddNames << RequestState::GOOD
+        << (QStringList() << "." << "quote\"d.txt" << "back\\slash" << "end\\" << "br}ace]s, [and {"
+                          << QString::fromUtf8("\xC3\xBCml\xC3\xA4ut"));
+
+    //The result may come first, and a nested "result" key, or "status" in a string, is not the top level one
+    QTest::newRow("result before status")
+        << QByteArray(R"JSON({"result":[{"name":"a.txt","path":"/u/a.txt","type":"file","format":"raw","length":1}],)JSON"
+                      R"JSON("message":"status","meta":{"result":[1,2],"status":"error"},"status":"success"})JSON")
+        << RequestState::GOOD << (QStringList() << "a.txt");
+
+    QTest::newRow("empty result")
+        << QByteArray(" {\n \"status\" : \"success\" ,\n \"result\" : [ ]\n }\n")
+        << RequestState::GOOD << QStringList();
+
+    QTest::newRow("error status")
+        << QByteArray(R"JSON({"status":"error","message":"File/folder does not exist","version":"2.2.0","result":null})JSON")
+        << RequestState::EXPLICIT_ERROR << QStringList();
+
+    QTest::newRow("no status")
+        << QByteArray(R"JSON({"result":[]})JSON")
+        << RequestState::MISSING_REPLY_STATUS << QStringList();
+
+    QTest::newRow("no result")
+        << QByteArray(R"JSON({"status":"success","result":{}})JSON")
+        << RequestState::MISSING_REPLY_DATA << QStringList();
+
+    QTest::newRow("number element")
+        << QByteArray(R"JSON({"status":"success","result":[{"name":"a.txt","path":"/u/a.txt","type":"file","format":"raw","length":1},42]})JSON")
+        << RequestState::MISSING_REPLY_DATA << QStringList();
+
+    QTest::newRow("string element")
+        << QByteArray(R"JSON({"status":"success","result":["a.txt"]})JSON")
+        << RequestState::MISSING_REPLY_DATA << QStringList();
+
+    QTest::newRow("entry without a path")
+        << QByteArray(R"JSON({"status":"success","result":[{"name":"a.txt","type":"file","format":"raw"}]})JSON")
+        << RequestState::MISSING_REPLY_DATA << QStringList();
+
+    QTest::newRow("truncated in entry") << oddNames.left(oddNames.indexOf("back")) << RequestState::JSON_PARSE_ERROR << QStringList();
+    QTest::newRow("truncated after result") << oddNames.left(oddNames.lastIndexOf('}')) << RequestState::JSON_PARSE_ERROR << QStringList();
+
+    QTest::newRow("not an object") << QByteArray(R"JSON([{"status":"success"}])JSON") << RequestState::JSON_PARSE_ERROR << QStringList();
+}
+
+void TestListingParser::splitAtEveryByte_data()
+{
+    addListingRows();
+}
+
+void TestListingParser::splitAtEveryByte()
+{
+    QFETCH(QByteArray, replyText);
+    QFETCH(RequestState, expectedState);
+    QFETCH(QStringList, expectedNames);
+
+    for (int splitAt = 0; splitAt <= replyText.size(); splitAt++)
+    {
+        QStringList entryNames;
+        RequestState finalState = feedListing(QList<QByteArray>() << replyText.left(splitAt) << replyText.mid(splitAt), &entryNames);
+
+        QCOMPARE(finalState, expectedState);
+        //A failed listing may have given out the entries before its fault, so only a good one is checked in full
+        if (expectedState == RequestState::GOOD) QCOMPARE(entryNames, expectedNames);
+    }
+}
+
+void TestListingParser::oneByteAtATime_data()
+{
+    addListingRows();
+}
+
+void TestListingParser::oneByteAtATime()
+{
+    QFETCH(QByteArray, replyText);
+    QFETCH(RequestState, expectedState);
+    QFETCH(QStringList, expectedNames);
+
+    QList<QByteArray> pieces;
+    for (int i = 0; i < replyText.size(); i++)
+    {
+        pieces.append(replyText.mid(i, 1));
+    }
+
+    QStringList entryNames;
+    QCOMPARE(feedListing(pieces, &entryNames), expectedState);
+    if (expectedState == RequestState::GOOD) QCOMPARE(entryNames, expectedNames);
+}
+
+RequestState TestListingParser::feedListing(const QList<QByteArray> &pieces, QStringList * entryNames)
+{
+    AgaveListingParser theParser;
+    qint64 totalBytes = 0;
+    for (const QByteArray &aPiece : pieces)
+    {
+        theParser.addData(aPiece);
+        totalBytes += aPiece.size();
+        for (const FileMetaData &anEntry : theParser.takeNewEntries())
+        {
+            entryNames->append(anEntry.getFileName());
+        }
+    }
+
+    if (theParser.getBytesRead() != totalBytes) return RequestState::INTERNAL_ERROR;
+    return theParser.getFinalState();
+}
+
+QTEST_MAIN(TestListingParser)
+#include "tst_listingparser.moc"
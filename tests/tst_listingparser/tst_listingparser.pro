@@ -0,0 +1,6 @@
+TARGET = tst_listingparser
+
+include(../tests.pri)
+
+SOURCES += \
+    tst_listingparser.cpp
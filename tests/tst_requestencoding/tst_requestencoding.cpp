@@ -0,0 +1,172 @@
+/*********************************************************************************
+**
+** Copyright (c) 2017 The University of Notre Dame
+** Copyright (c) 2017 The Regents of the University of California
+**
+** Redistribution and use in source and binary forms, with or without modification,
+** are permitted provided that the following conditions are met:
+**
+** 1. Redistributions of source code must retain the above copyright notice, this
+** list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright notice, this
+** list of conditions and the following disclaimer in the documentation and/or other
+** materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its contributors may
+** be used to endorse or promote products derived from this software without specific
+** prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+** EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+** SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+** TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+** BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+** CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+** IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+** SUCH DAMAGE.
+**
+***********************************************************************************/
+
+// Contributors:
+
+#include "mockagaveserver.h"
+#include "agaveInterfaces/agavehandler.h"
+
+#include <QtTest>
+#include <QNetworkAccessManager>
+
+//Checks the URLs, post data and login header sent for names with spaces, non-ASCII text and characters
+//which have a meaning in a URL or in post data
+class TestRequestEncoding : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void loginIsSentAsUtf8();
+    void listingPathIsEncoded();
+    void listingPathSlashesAreCollapsed();
+    void postArgIsEncoded();
+
+private:
+    MockRequest findRequest(QByteArray method, QByteArray pathStart);
+
+    //A user name and a password which is not ASCII, and holds the separators of post data
+    const QString userName = QString::fromUtf8("t\xC3\xABster");
+    const QString password = QString::fromUtf8("p&ss=w\xC3\xB6rd%");
+    //A folder with a space, a non-ASCII name, and the characters which end a path or begin an encoding
+    const QString oddFolder = QString::fromUtf8("/t\xC3\xABster/a b/\xC3\xBC#?%");
+
+    MockAgaveServer * mockServer = nullptr;
+    QNetworkAccessManager * netManager = nullptr;
+    AgaveHandler * theHandler = nullptr;
+};
+
+void TestRequestEncoding::init()
+{
+    mockServer = new MockAgaveServer();
+    QVERIFY(mockServer->start());
+    mockServer->addStoredFile(oddFolder + "/data.txt", "some data");
+
+    netManager = new QNetworkAccessManager();
+    theHandler = new AgaveHandler(netManager);
+    theHandler->setAgaveConnectionParams(mockServer->getTenantURL(), "testClient", "mockStorage");
+
+    RemoteDataReply * authReply = theHandler->performAuth(userName, password);
+    QVERIFY(authReply != nullptr);
+    QSignalSpy authSpy(authReply, SIGNAL(haveAuthReply(RequestState)));
+    QVERIFY(authSpy.wait(5000));
+    QCOMPARE(authSpy.at(0).at(0).value<RequestState>(), RequestState::GOOD);
+}
+
+void TestRequestEncoding::cleanup()
+{
+    delete theHandler;
+    delete netManager;
+    delete mockServer;
+}
+
+void TestRequestEncoding::loginIsSentAsUtf8()
+{
+    //Client registration uses the user's name and password, as a Basic header
+    MockRequest clientRequest = findRequest("GET", "/clients/v2/testClient");
+    QCOMPARE(clientRequest.headers.value("authorization"), QByteArray("Basic ") + QString(userName + ":" + password).toUtf8().toBase64());
+
+    //The token request sends them as post args, where & and = must not split the password
+    MockRequest tokenRequest = findRequest("POST", "/token");
+    QCOMPARE(tokenRequest.body, QByteArray("username=t%C3%ABster&password=p%26ss%3Dw%C3%B6rd%25&grant_type=password&scope=PRODUCTION"));
+}
+
+void TestRequestEncoding::listingPathIsEncoded()
+{
+    mockServer->clearRequestLog();
+
+    RemoteDataReply * lsReply = theHandler->remoteLS(oddFolder);
+    QVERIFY(lsReply != nullptr);
+    QSignalSpy lsSpy(lsReply, SIGNAL(haveLSReply(RequestState,QList<FileMetaData>)));
+    QVERIFY(lsSpy.wait(5000));
+
+    QCOMPARE(mockServer->getRequestLog().size(), 1);
+    QCOMPARE(mockServer->getRequestLog().at(0).path,
+             QByteArray("/files/v2/listings/system/mockStorage/t%C3%ABster/a%20b/%C3%BC%23%3F%25"));
+
+    //The server found the folder, so the whole name arrived, with nothing taken as a query or fragment
+    QCOMPARE(lsSpy.at(0).at(0).value<RequestState>(), RequestState::GOOD);
+    QList<FileMetaData> fileList = lsSpy.at(0).at(1).value<QList<FileMetaData>>();
+    bool foundFile = false;
+    for (const FileMetaData &aFile : fileList)
+    {
+        if (aFile.getFullPath() == oddFolder + "/data.txt") foundFile = true;
+    }
+    QVERIFY(foundFile);
+}
+
+void TestRequestEncoding::listingPathSlashesAreCollapsed()
+{
+    mockServer->clearRequestLog();
+
+    RemoteDataReply * lsReply = theHandler->remoteLS(QString::fromUtf8("//t\xC3\xABster//a b///\xC3\xBC#?%/"));
+    QVERIFY(lsReply != nullptr);
+    QSignalSpy lsSpy(lsReply, SIGNAL(haveLSReply(RequestState,QList<FileMetaData>)));
+    QVERIFY(lsSpy.wait(5000));
+
+    QCOMPARE(mockServer->getRequestLog().size(), 1);
+    QCOMPARE(mockServer->getRequestLog().at(0).path,
+             QByteArray("/files/v2/listings/system/mockStorage/t%C3%ABster/a%20b/%C3%BC%23%3F%25/"));
+}
+
+void TestRequestEncoding::postArgIsEncoded()
+{
+    mockServer->clearRequestLog();
+
+    RemoteDataReply * mkdirReply = theHandler->mkRemoteDir(oddFolder, "a&b=c d");
+    QVERIFY(mkdirReply != nullptr);
+    QSignalSpy mkdirSpy(mkdirReply, SIGNAL(haveMkdirReply(RequestState,FileMetaData)));
+    QVERIFY(mkdirSpy.wait(5000));
+
+    QCOMPARE(mockServer->getRequestLog().size(), 1);
+    MockRequest mkdirRequest = mockServer->getRequestLog().at(0);
+    QCOMPARE(mkdirRequest.path, QByteArray("/files/v2/media/system/mockStorage/t%C3%ABster/a%20b/%C3%BC%23%3F%25"));
+    QCOMPARE(mkdirRequest.body, QByteArray("action=mkdir&path=a%26b%3Dc%20d"));
+
+    //The server split the form into the same action and name
+    QCOMPARE(mkdirSpy.at(0).at(0).value<RequestState>(), RequestState::GOOD);
+    QCOMPARE(mkdirSpy.at(0).at(1).value<FileMetaData>().getFullPath(), oddFolder + "/a&b=c d");
+}
+
+MockRequest TestRequestEncoding::findRequest(QByteArray method, QByteArray pathStart)
+{
+    for (const MockRequest &aRequest : mockServer->getRequestLog())
+    {
+        if ((aRequest.method == method) && aRequest.path.startsWith(pathStart)) return aRequest;
+    }
+    return MockRequest();
+}
+
+QTEST_MAIN(TestRequestEncoding)
+#include "tst_requestencoding.moc"
@@ -0,0 +1,6 @@
+TARGET = tst_requestencoding
+
+include(../tests.pri)
+
+SOURCES += \
+    tst_requestencoding.cpp
@@ -0,0 +1,248 @@
+/*********************************************************************************
+**
+** Copyright (c) 2017 The University of Notre Dame
+** Copyright (c) 2017 The Regents of the University of California
+**
+** Redistribution and use in source and binary forms, with or without modification,
+** are permitted provided that the following conditions are met:
+**
+** 1. Redistributions of source code must retain the above copyright notice, this
+** list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright notice, this
+** list of conditions and the following disclaimer in the documentation and/or other
+** materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its contributors may
+** be used to endorse or promote products derived from this software without specific
+** prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+** EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+** SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+** TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+** BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+** CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+** IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+** SUCH DAMAGE.
+**
+***********************************************************************************/
+
+// Contributors:
+// Written by Peter Sempolinski, for the Natural Hazard Modeling Laboratory, director: Ahsan Kareem, at Notre Dame
+
+#include "mockagaveserver.h"
+#include "agaveInterfaces/agavehandler.h"
+
+#include <QtTest>
+#include <QNetworkAccessManager>
+#include <QThread>
+#include <QElapsedTimer>
+
+//Notes each signal it gets, and the thread it got it on
+class ReplyRecorder : public QObject
+{
+    Q_OBJECT
+
+public:
+    QList<QThread *> arrivalThreads;
+    QList<RemoteDataInterfaceState> stateList;
+    QList<RequestState> replyStates;
+    QList<FileMetaData> fileList;
+
+public slots:
+    void noteConnectionState(RemoteDataInterfaceState newState)
+    {
+        stateList.append(newState);
+        arrivalThreads.append(QThread::currentThread());
+    }
+
+    void noteAuthReply(RequestState replyState)
+    {
+        replyStates.append(replyState);
+        arrivalThreads.append(QThread::currentThread());
+    }
+
+    void noteLSReply(RequestState replyState, QList<FileMetaData> fileDataList)
+    {
+        replyStates.append(replyState);
+        fileList = fileDataList;
+        arrivalThreads.append(QThread::currentThread());
+    }
+};
+
+//A thread with no event loop, which asks for a listing and only gets it once it handles its events
+class NoLoopCaller : public QThread
+{
+    Q_OBJECT
+
+public:
+    AgaveHandler * theHandler = nullptr;
+
+    bool replyOnCallerThread = false;
+    bool nothingBeforeEvents = false;
+    bool arrivedOnCallerThread = false;
+    RequestState listingState = RequestState::PENDING;
+    int entryCount = -1;
+
+protected:
+    void run() override
+    {
+        ReplyRecorder lsRecorder;
+        RemoteDataReply * lsReply = theHandler->remoteLS("/testUser/data");
+        if (lsReply == nullptr) return;
+        replyOnCallerThread = (lsReply->thread() == QThread::currentThread());
+        QObject::connect(lsReply, SIGNAL(haveLSReply(RequestState,QList<FileMetaData>)),
+                         &lsRecorder, SLOT(noteLSReply(RequestState,QList<FileMetaData>)));
+
+        //The request is made and answered meanwhile, but its result waits for this thread
+        QThread::msleep(500);
+        nothingBeforeEvents = lsRecorder.replyStates.isEmpty();
+
+        QElapsedTimer waitClock;
+        waitClock.start();
+        while (lsRecorder.replyStates.isEmpty() && (waitClock.elapsed() < 5000))
+        {
+            QCoreApplication::processEvents(QEventLoop::AllEvents, 50);
+            QThread::msleep(10);
+        }
+        if (lsRecorder.replyStates.isEmpty()) return;
+
+        listingState = lsRecorder.replyStates.at(0);
+        entryCount = lsRecorder.fileList.size();
+        arrivedOnCallerThread = (lsRecorder.arrivalThreads.at(0) == QThread::currentThread());
+    }
+};
+
+class TestThreading : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void stateChangesArriveOnGuiThread();
+    void listingArrivesOnGuiThread();
+    void threadWithoutEventLoopGetsReplyWhenHandlingEvents();
+
+private:
+    bool login();
+
+    MockAgaveServer * mockServer = nullptr;
+    QNetworkAccessManager * netManager = nullptr;
+    AgaveHandler * theHandler = nullptr;
+    ReplyRecorder * stateRecorder = nullptr;
+    bool handlerGone = false;
+};
+
+void TestThreading::init()
+{
+    mockServer = new MockAgaveServer();
+    QVERIFY(mockServer->start());
+    mockServer->addStoredFile("/testUser/data/first.txt", "first");
+    mockServer->addStoredFile("/testUser/data/second.txt", "second");
+
+    netManager = new QNetworkAccessManager();
+    theHandler = new AgaveHandler(netManager);
+    QVERIFY(theHandler->moveToOwnThread());
+    QVERIFY(theHandler->thread() != QThread::currentThread());
+
+    handlerGone = false;
+    QObject::connect(theHandler, &QObject::destroyed, this, [this]() { handlerGone = true; });
+
+    stateRecorder = new ReplyRecorder();
+    QObject::connect(theHandler, SIGNAL(connectionStateChanged(RemoteDataInterfaceState)),
+                     stateRecorder, SLOT(noteConnectionState(RemoteDataInterfaceState)));
+
+    theHandler->setAgaveConnectionParams(mockServer->getTenantURL(), "testClient", "mockStorage");
+}
+
+void TestThreading::cleanup()
+{
+    //A handler on its own thread is deleted there, and its thread then stops
+    if (theHandler != nullptr)
+    {
+        theHandler->deleteLater();
+        QTRY_VERIFY_WITH_TIMEOUT(handlerGone, 5000);
+        theHandler = nullptr;
+    }
+
+    delete stateRecorder;
+    delete netManager;
+    delete mockServer;
+}
+
+void TestThreading::stateChangesArriveOnGuiThread()
+{
+    ReplyRecorder authRecorder;
+    RemoteDataReply * authReply = theHandler->performAuth("testUser", "testPass");
+    QVERIFY(authReply != nullptr);
+    QCOMPARE(authReply->thread(), QThread::currentThread());
+
+    //Connected after the call returns, and still not missed
+    QObject::connect(authReply, SIGNAL(haveAuthReply(RequestState)), &authRecorder, SLOT(noteAuthReply(RequestState)));
+
+    QTRY_COMPARE_WITH_TIMEOUT(authRecorder.replyStates.size(), 1, 5000);
+    QCOMPARE(authRecorder.replyStates.at(0), RequestState::GOOD);
+    QCOMPARE(authRecorder.arrivalThreads.at(0), QThread::currentThread());
+
+    QTRY_VERIFY_WITH_TIMEOUT(stateRecorder->stateList.contains(RemoteDataInterfaceState::CONNECTED), 5000);
+    QVERIFY(stateRecorder->stateList.contains(RemoteDataInterfaceState::READY_TO_AUTH));
+    for (QThread * aThread : stateRecorder->arrivalThreads)
+    {
+        QCOMPARE(aThread, QThread::currentThread());
+    }
+}
+
+void TestThreading::listingArrivesOnGuiThread()
+{
+    QVERIFY(login());
+
+    ReplyRecorder lsRecorder;
+    RemoteDataReply * lsReply = theHandler->remoteLS("/testUser/data");
+    QVERIFY(lsReply != nullptr);
+    QCOMPARE(lsReply->thread(), QThread::currentThread());
+    QObject::connect(lsReply, SIGNAL(haveLSReply(RequestState,QList<FileMetaData>)),
+                     &lsRecorder, SLOT(noteLSReply(RequestState,QList<FileMetaData>)));
+
+    QTRY_COMPARE_WITH_TIMEOUT(lsRecorder.replyStates.size(), 1, 5000);
+    QCOMPARE(lsRecorder.replyStates.at(0), RequestState::GOOD);
+    QCOMPARE(lsRecorder.arrivalThreads.at(0), QThread::currentThread());
+    //The folder itself, then its two files
+    QCOMPARE(lsRecorder.fileList.size(), 3);
+}
+
+void TestThreading::threadWithoutEventLoopGetsReplyWhenHandlingEvents()
+{
+    QVERIFY(login());
+
+    NoLoopCaller callerThread;
+    callerThread.theHandler = theHandler;
+    callerThread.start();
+
+    //This thread runs the mock server meanwhile
+    QTRY_VERIFY_WITH_TIMEOUT(callerThread.isFinished(), 10000);
+    callerThread.wait();
+
+    QVERIFY(callerThread.replyOnCallerThread);
+    QVERIFY(callerThread.nothingBeforeEvents);
+    QCOMPARE(callerThread.listingState, RequestState::GOOD);
+    QVERIFY(callerThread.arrivedOnCallerThread);
+    QCOMPARE(callerThread.entryCount, 3);
+}
+
+bool TestThreading::login()
+{
+    RemoteDataReply * authReply = theHandler->performAuth("testUser", "testPass");
+    if (authReply == nullptr) return false;
+
+    QSignalSpy authSpy(authReply, SIGNAL(haveAuthReply(RequestState)));
+    if (!authSpy.wait(5000)) return false;
+    return (authSpy.at(0).at(0).value<RequestState>() == RequestState::GOOD);
+}
+
+QTEST_MAIN(TestThreading)
+#include "tst_threading.moc"
@@ -0,0 +1,6 @@
+TARGET = tst_threading
+
+include(../tests.pri)
+
+SOURCES += \
+    tst_threading.cpp